@@ -0,0 +1,234 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "videosurface.h"
+#include "videoproxy.h"
+#include "framescaler.h"
+#include "framebufferpool.h"
+#include "perfcounters.h"
+
+#include "dfm-base/dfm_desktop_defines.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QTimer>
+#include <QVideoSurfaceFormat>
+
+#include <algorithm>
+
+namespace ddplugin_videowallpaper {
+DFM_LOG_REISGER_CATEGORY(DDP_VIDEOWALLPAPER_NAMESPACE)
+}
+
+using namespace ddplugin_videowallpaper;
+DFMBASE_USE_NAMESPACE
+
+static constexpr int kFrameTimeout = 5000;   // ms
+
+static QVideoFrame::PixelFormat pixelFormat(const QString &name)
+{
+    if (name == "yuv420p")
+        return QVideoFrame::Format_YUV420P;
+    if (name == "nv12")
+        return QVideoFrame::Format_NV12;
+    if (name == "rgb32")
+        return QVideoFrame::Format_RGB32;
+    if (name == "argb32")
+        return QVideoFrame::Format_ARGB32;
+    return QVideoFrame::Format_Invalid;
+}
+
+// a frame with the synthetic pattern, the planes are contiguous.
+static QVideoFrame createFrame(const QSize &size, QVideoFrame::PixelFormat fmt)
+{
+    const bool yuv = fmt == QVideoFrame::Format_YUV420P || fmt == QVideoFrame::Format_NV12;
+    const int bytesPerLine = yuv ? size.width() : size.width() * 4;
+    const int bytes = yuv ? size.width() * size.height() * 3 / 2 : bytesPerLine * size.height();
+
+    QVideoFrame frame(bytes, size, bytesPerLine, fmt);
+    if (frame.map(QAbstractVideoBuffer::WriteOnly)) {
+        uchar *data = frame.bits();
+        for (int i = 0; i < bytes; ++i)
+            data[i] = static_cast<uchar>((i * 7 + i / bytesPerLine) & 0xff);
+        frame.unmap();
+    }
+    return frame;
+}
+
+static QList<QSize> parseScreens(const QString &arg)
+{
+    QList<QSize> ret;
+    for (const QString &item : arg.split(',', QString::SkipEmptyParts)) {
+        const QStringList wh = item.split('x');
+        if (wh.size() == 2 && wh.first().toInt() > 0 && wh.last().toInt() > 0)
+            ret.append(QSize(wh.first().toInt(), wh.last().toInt()));
+    }
+    return ret;
+}
+
+static double percentile(const QVector<qint64> &sorted, double p)
+{
+    if (sorted.isEmpty())
+        return 0;
+    const int idx = qBound(0, static_cast<int>(p * (sorted.size() - 1) + 0.5), sorted.size() - 1);
+    return sorted.at(idx) / 1000.0;
+}
+
+// the frame pipeline of QtMultimedia backend only, libdmr draws the frames itself.
+// usage: QT_QPA_PLATFORM=offscreen videowallpaper-pipeline-benchmark --size 1920x1080 --format nv12 --screens 1920x1080,1366x768
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption({ "size", "size of the video frames.", "WxH", "1920x1080" });
+    parser.addOption({ "format", "yuv420p, nv12, rgb32 or argb32.", "format", "yuv420p" });
+    parser.addOption({ "screens", "the screens showing the video.", "WxH,...", "1920x1080" });
+    parser.addOption({ "frames", "frames to present.", "count", "300" });
+    parser.addOption({ "warmup", "frames not counted.", "count", "20" });
+    parser.addOption({ "output", "write the json result to file.", "file" });
+    parser.process(app);
+
+    QTextStream err(stderr);
+    err << "measuring the QtMultimedia backend, the libdmr backend is not covered\n";
+    const QList<QSize> sizes = parseScreens(parser.value("size"));
+    const QList<QSize> screens = parseScreens(parser.value("screens"));
+    const QVideoFrame::PixelFormat fmt = pixelFormat(parser.value("format"));
+    const int frames = parser.value("frames").toInt();
+    const int warmup = qMax(parser.value("warmup").toInt(), 0);
+    if (sizes.size() != 1 || screens.isEmpty() || fmt == QVideoFrame::Format_Invalid || frames < 1) {
+        err << "invalid arguments\n";
+        return 1;
+    }
+
+    // the widgets on screens.
+    QList<VideoProxyPointer> widgets;
+    for (int i = 0; i < screens.size(); ++i) {
+        VideoProxyPointer bwp(new VideoProxy());
+        bwp->setProperty(DesktopFrameProperty::kPropScreenName, QString("screen-%0").arg(i));
+        bwp->setGeometry(QRect(QPoint(0, 0), screens.at(i)));
+        bwp->show();
+        widgets.append(bwp);
+    }
+
+    VideoSurface surface;
+    FrameScaler scaler;
+
+    // what WallpaperEngine::catchImage does for the visible screens.
+    QObject::connect(&surface, &VideoSurface::pushImage, &scaler, [&scaler, &widgets](const QImage &img) {
+        scaler.scale(img, widgets);
+    });
+
+    const QVideoFrame frame = createFrame(sizes.first(), fmt);
+    QVideoSurfaceFormat format(sizes.first(), fmt);
+    if (!surface.start(format)) {
+        err << "can not start surface\n";
+        return 1;
+    }
+
+    QVector<qint64> latency;   // ns
+    latency.reserve(frames);
+    QElapsedTimer total;
+    FrameCounters poolStart;
+    QEventLoop loop;
+    // wakes the loop up to check the timeout.
+    QTimer wakeup;
+    wakeup.start(100);
+    for (int i = 0; i < warmup + frames; ++i) {
+        if (i == warmup) {
+            PerfCounters::instance()->reset();
+            poolStart = FrameBufferPool::instance()->counters();
+            total.start();
+        }
+
+        QList<quint64> presented;
+        for (const VideoProxyPointer &bwp : widgets)
+            presented.append(bwp->counters()->presented.loadAcquire());
+
+        QElapsedTimer timer;
+        timer.start();
+        surface.present(frame);
+
+        // wait until all widgets got the scaled frame and painted it.
+        bool done = false;
+        while (!done) {
+            if (timer.elapsed() > kFrameTimeout) {
+                err << "frame " << i << " is not delivered\n";
+                return 1;
+            }
+
+            loop.processEvents(QEventLoop::AllEvents | QEventLoop::WaitForMoreEvents);
+            done = true;
+            for (int w = 0; w < widgets.size(); ++w)
+                done = done && widgets.at(w)->counters()->presented.loadAcquire() > presented.at(w);
+        }
+
+        for (const VideoProxyPointer &bwp : widgets)
+            bwp->repaint();
+
+        if (i >= warmup)
+            latency.append(timer.nsecsElapsed());
+    }
+
+    const qint64 elapsed = total.nsecsElapsed();
+    const FrameCounters pool = FrameBufferPool::instance()->counters();
+    surface.stop();
+
+    QVector<qint64> sorted = latency;
+    std::sort(sorted.begin(), sorted.end());
+
+    QJsonObject latencyObj;
+    latencyObj.insert("p50", percentile(sorted, 0.5));
+    latencyObj.insert("p90", percentile(sorted, 0.9));
+    latencyObj.insert("p99", percentile(sorted, 0.99));
+    latencyObj.insert("max", percentile(sorted, 1.0));
+
+    QJsonObject allocObj;
+    allocObj.insert("buffers", static_cast<double>(pool.allocations - poolStart.allocations));
+    allocObj.insert("bytes", static_cast<double>(pool.allocatedBytes - poolStart.allocatedBytes));
+    allocObj.insert("copies", static_cast<double>(pool.copied - poolStart.copied));
+    allocObj.insert("copiedBytes", static_cast<double>(pool.copiedBytes - poolStart.copiedBytes));
+
+    QJsonArray screenArray;
+    for (const QSize &size : screens)
+        screenArray.append(QString("%0x%1").arg(size.width()).arg(size.height()));
+
+    QJsonObject root;
+    // built without USE_LIBDMR, the frames of libdmr backend are not measured.
+    root.insert("backend", QString("QtMultimedia"));
+    root.insert("format", parser.value("format"));
+    root.insert("size", parser.value("size"));
+    root.insert("screens", screenArray);
+    root.insert("frames", frames);
+    root.insert("elapsedMs", elapsed / 1e6);
+    root.insert("fps", elapsed > 0 ? frames * 1e9 / elapsed : 0.0);
+    root.insert("latencyUs", latencyObj);
+    root.insert("allocations", allocObj);
+    root.insert("counters", QJsonObject::fromVariantMap(PerfCounters::instance()->snapshot()));
+
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+    if (parser.isSet("output")) {
+        QFile file(parser.value("output"));
+        if (!file.open(QFile::WriteOnly)) {
+            err << "can not write " << parser.value("output") << "\n";
+            return 1;
+        }
+        file.write(json);
+    } else {
+        QTextStream(stdout) << json;
+    }
+
+    widgets.clear();
+    return 0;
+}
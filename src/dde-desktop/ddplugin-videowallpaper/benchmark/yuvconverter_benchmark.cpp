@@ -0,0 +1,106 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "yuvconverter.h"
+
+#include <QImage>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+#include <cstdlib>
+#include <vector>
+
+using namespace ddplugin_videowallpaper;
+
+// usage: videowallpaper-yuv-benchmark [width height target_width target_height iterations]
+int main(int argc, char *argv[])
+{
+    const int width = argc > 2 ? atoi(argv[1]) : 1920;
+    const int height = argc > 2 ? atoi(argv[2]) : 1080;
+    const int targetWidth = argc > 4 ? atoi(argv[3]) : 1366;
+    const int targetHeight = argc > 4 ? atoi(argv[4]) : 768;
+    const int iterations = argc > 5 ? atoi(argv[5]) : 200;
+
+    QTextStream out(stdout);
+    out.setFieldAlignment(QTextStream::AlignLeft);
+    if (width < 2 || height < 2 || targetWidth < 1 || targetHeight < 1 || iterations < 1) {
+        out << "invalid arguments\n";
+        return 1;
+    }
+
+    // synthetic I420 and NV12 frames
+    std::vector<uint8_t> luma(static_cast<size_t>(width) * height);
+    std::vector<uint8_t> chroma(static_cast<size_t>(width) * ((height + 1) / 2));
+    for (size_t i = 0; i < luma.size(); ++i)
+        luma[i] = static_cast<uint8_t>((i * 7) & 0xff);
+    for (size_t i = 0; i < chroma.size(); ++i)
+        chroma[i] = static_cast<uint8_t>((i * 13) & 0xff);
+
+    YuvFrame i420;
+    i420.layout = YuvFrame::kI420;
+    i420.width = width;
+    i420.height = height;
+    i420.y = luma.data();
+    i420.yStride = width;
+    i420.u = chroma.data();
+    i420.uStride = width / 2;
+    i420.v = chroma.data() + chroma.size() / 2;
+    i420.vStride = width / 2;
+
+    YuvFrame nv12 = i420;
+    nv12.layout = YuvFrame::kNV12;
+    nv12.uStride = width;
+    nv12.v = nullptr;
+    nv12.vStride = 0;
+
+    QImage full(width, height, QImage::Format_RGB32);
+    QImage target(QSize(width, height).scaled(targetWidth, targetHeight, Qt::KeepAspectRatio), QImage::Format_RGB32);
+
+    auto report = [&out, iterations](const QString &name, qint64 ns) {
+        out << qSetFieldWidth(36) << name << qSetFieldWidth(0)
+            << QString::number(ns / 1e6 / iterations, 'f', 3) << " ms/frame\n";
+    };
+
+    out << "frame " << width << "x" << height << " target " << target.width() << "x" << target.height()
+        << " iterations " << iterations << "\n";
+
+    // what the surface did before: copy the RGB frame and scale it for the widget.
+    {
+        QImage rgb(width, height, QImage::Format_RGB32);
+        rgb.fill(Qt::darkGray);
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < iterations; ++i) {
+            QImage copied = QImage(rgb.constBits(), width, height, rgb.bytesPerLine(), rgb.format()).copy();
+            QImage scaled = copied.scaled(target.size(), Qt::KeepAspectRatio);
+            Q_UNUSED(scaled)
+        }
+        report("current: copy + QImage::scaled", timer.nsecsElapsed());
+    }
+
+    for (YuvConverter::Kernel kernel : { YuvConverter::kScalar, YuvConverter::kSSE2,
+                                         YuvConverter::kAVX2, YuvConverter::kNEON }) {
+        if (!YuvConverter::isSupported(kernel))
+            continue;
+
+        YuvConverter conv(YuvConverter::kBT709, YuvConverter::kLimited, kernel);
+        const QString name = YuvConverter::kernelName(kernel);
+        for (const YuvFrame *frame : { &i420, &nv12 }) {
+            const QString layout = frame->layout == YuvFrame::kNV12 ? "nv12" : "i420";
+
+            QElapsedTimer timer;
+            timer.start();
+            for (int i = 0; i < iterations; ++i)
+                conv.convert(*frame, full.bits(), full.bytesPerLine(), full.width(), full.height());
+            report(QString("%0 %1 full size").arg(name).arg(layout), timer.nsecsElapsed());
+
+            timer.restart();
+            for (int i = 0; i < iterations; ++i)
+                conv.convert(*frame, target.bits(), target.bytesPerLine(), target.width(), target.height());
+            report(QString("%0 %1 fused downscale").arg(name).arg(layout), timer.nsecsElapsed());
+        }
+    }
+
+    return 0;
+}
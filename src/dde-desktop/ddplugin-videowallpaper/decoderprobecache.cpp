@@ -0,0 +1,215 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "decoderprobecache.h"
+#include "mediaindex.h"
+#include "ddplugin_videowallpaper_global.h"
+
+#include <QtConcurrent>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QSysInfo>
+
+using namespace ddplugin_videowallpaper;
+
+static constexpr int kCacheVersion = 1;
+
+static QString readLine(const QString &file)
+{
+    QFile f(file);
+    if (!f.open(QFile::ReadOnly))
+        return QString();
+    return QString::fromLatin1(f.readLine()).trimmed();
+}
+
+QString DecodeKey::toString() const
+{
+    return QString("%0/%1/%2x%3").arg(codec).arg(profile).arg(resolution.width()).arg(resolution.height());
+}
+
+namespace ddplugin_videowallpaper {
+struct ProbedStreams
+{
+    QMutex mtx;
+    QHash<QString, DecodeKey> keys;   // file and its time -- key
+    QSet<QString> probing;
+};
+}
+
+SystemProbeBackend::SystemProbeBackend(MediaIndex *idx)
+    : index(idx)
+    , probed(new ProbedStreams)
+{
+
+}
+
+QString SystemProbeBackend::driverFingerprint()
+{
+    QStringList ids;
+    QDir drm("/sys/class/drm");
+    for (const QString &card : drm.entryList({ "card*" }, QDir::Dirs | QDir::System, QDir::Name)) {
+        // the connectors such as card0-HDMI-A-1.
+        if (card.contains('-'))
+            continue;
+
+        const QString dev = drm.absoluteFilePath(card) + "/device/";
+        const QString driver = QFileInfo(QFileInfo(dev + "driver").symLinkTarget()).fileName();
+        ids.append(QString("%0:%1:%2:%3").arg(readLine(dev + "vendor")).arg(readLine(dev + "device"))
+                   .arg(driver).arg(readLine("/sys/module/" + driver + "/version")));
+    }
+
+    // the drivers of VA-API and VDPAU can be overridden.
+    ids.append(qEnvironmentVariable("LIBVA_DRIVER_NAME"));
+    ids.append(qEnvironmentVariable("VDPAU_DRIVER"));
+    ids.append(QSysInfo::kernelVersion());
+    return ids.join('|');
+}
+
+DecodeKey SystemProbeBackend::streamOf(const QString &file)
+{
+    MediaInfo info = index ? index->entries().value(file) : MediaInfo();
+
+    // the transcoded renditions are not in index, ffprobe never runs in the GUI thread.
+    if (info.path.isEmpty()) {
+        const QFileInfo fi(file);
+        const QString id = file + QString::number(fi.lastModified().toMSecsSinceEpoch());
+        QMutexLocker lk(&probed->mtx);
+        auto it = probed->keys.find(id);
+        if (it != probed->keys.end())
+            return it.value();
+
+        if (!probed->probing.contains(id)) {
+            probed->probing.insert(id);
+            QSharedPointer<ProbedStreams> streams = probed;
+            QtConcurrent::run([streams, file, id]() {
+                const MediaInfo probedInfo = MediaIndex::probe(file);
+                QMutexLocker lk(&streams->mtx);
+                streams->probing.remove(id);
+                streams->keys.insert(id, DecodeKey { probedInfo.codec, probedInfo.profile, probedInfo.resolution });
+            });
+        }
+        return DecodeKey();
+    }
+
+    return DecodeKey { info.codec, info.profile, info.resolution };
+}
+
+DecoderProbeCache::DecoderProbeCache(DecoderProbeBackend *b, const QString &file)
+    : backend(b)
+    , path(file)
+{
+
+}
+
+QString DecoderProbeCache::cacheFile()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/deepin/dde-desktop/video-wallpaper-decoders.json";
+}
+
+DecodePath DecoderProbeCache::lookup(const QString &file)
+{
+    load();
+    const DecodeKey key = backend->streamOf(file);
+    if (!key.isValid())
+        return DecodePath();
+
+    return paths.value(key.toString());
+}
+
+bool DecoderProbeCache::record(const QString &file, const DecodePath &dp)
+{
+    load();
+    const DecodeKey key = backend->streamOf(file);
+    if (!key.isValid() || !dp.isValid())
+        return false;
+
+    const QString id = key.toString();
+    const DecodePath old = paths.value(id);
+    DecodePath now = dp;
+    if (now.startup < 0)
+        now.startup = old.startup;
+    now.probed = QDateTime::currentSecsSinceEpoch();
+
+    const bool changed = old.hwdec != now.hwdec;
+    // the cost is only updated when it was unknown, the first play is the representative one.
+    if (!changed && (old.startup >= 0 || now.startup < 0))
+        return false;
+
+    fmInfo() << "decode path of" << id << now.hwdec << "startup" << now.startup << "drop rate" << now.dropRate;
+    paths.insert(id, now);
+    save();
+    return changed;
+}
+
+void DecoderProbeCache::load()
+{
+    if (loaded)
+        return;
+
+    loaded = true;
+    driver = backend->driverFingerprint();
+
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly))
+        return;
+
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    if (root.value("version").toInt() != kCacheVersion)
+        return;
+
+    // the paths are probed with another GPU or driver.
+    if (root.value("driver").toString() != driver) {
+        fmInfo() << "driver changed, discard the decode paths.";
+        return;
+    }
+
+    const QJsonObject streams = root.value("streams").toObject();
+    for (auto it = streams.begin(); it != streams.end(); ++it) {
+        const QJsonObject obj = it.value().toObject();
+        DecodePath dp;
+        dp.hwdec = obj.value("hwdec").toString();
+        dp.startup = static_cast<qint64>(obj.value("startup").toDouble(-1));
+        dp.dropRate = obj.value("dropRate").toDouble();
+        dp.probed = static_cast<qint64>(obj.value("probed").toDouble());
+        if (dp.isValid())
+            paths.insert(it.key(), dp);
+    }
+}
+
+void DecoderProbeCache::save() const
+{
+    QJsonObject streams;
+    for (auto it = paths.begin(); it != paths.end(); ++it) {
+        QJsonObject obj;
+        obj.insert("hwdec", it.value().hwdec);
+        obj.insert("startup", static_cast<double>(it.value().startup));
+        obj.insert("dropRate", it.value().dropRate);
+        obj.insert("probed", static_cast<double>(it.value().probed));
+        streams.insert(it.key(), obj);
+    }
+
+    QJsonObject root;
+    root.insert("version", kCacheVersion);
+    root.insert("driver", driver);
+    root.insert("streams", streams);
+
+    QFileInfo(path).absoluteDir().mkpath(".");
+    QSaveFile file(path);
+    if (!file.open(QFile::WriteOnly)) {
+        fmWarning() << "can not write decoder cache" << path;
+        return;
+    }
+
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    file.commit();
+}
@@ -0,0 +1,90 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef DECODERPROBECACHE_H
+#define DECODERPROBECACHE_H
+
+#include <QString>
+#include <QSize>
+#include <QHash>
+#include <QScopedPointer>
+#include <QSharedPointer>
+
+namespace ddplugin_videowallpaper {
+
+struct DecodeKey
+{
+    QString codec;
+    QString profile;
+    QSize resolution;
+    inline bool isValid() const
+    {
+        return !codec.isEmpty() && resolution.isValid();
+    }
+    QString toString() const;
+};
+
+struct DecodePath
+{
+    QString hwdec;          // the hwdec of mpv, "no" for software decoding
+    qint64 startup = -1;    // ms from opening the file to playing, -1 if unknown
+    qreal dropRate = 0;     // dropped frames / decoded frames
+    qint64 probed = 0;      // secs since epoch
+    inline bool isValid() const
+    {
+        return !hwdec.isEmpty();
+    }
+};
+
+class MediaIndex;
+struct ProbedStreams;
+// the source of stream and driver informations, a mock one is used in tests.
+class DecoderProbeBackend
+{
+public:
+    virtual ~DecoderProbeBackend() {}
+    // identifies the GPU and its driver, the paths recorded with other drivers are discarded.
+    virtual QString driverFingerprint() = 0;
+    virtual DecodeKey streamOf(const QString &file) = 0;
+};
+
+// reads the driver from sysfs and the stream from media index.
+class SystemProbeBackend : public DecoderProbeBackend
+{
+public:
+    explicit SystemProbeBackend(MediaIndex *index);
+    QString driverFingerprint() override;
+    // the files out of index, such as the transcoded renditions, are probed in background,
+    // their keys are invalid until then.
+    DecodeKey streamOf(const QString &file) override;
+private:
+    MediaIndex *index = nullptr;
+    QSharedPointer<ProbedStreams> probed;   // shared with the probing threads
+};
+
+// remembers the decode path that worked for a kind of stream on this machine.
+class DecoderProbeCache
+{
+public:
+    // the cache takes the ownership of backend.
+    explicit DecoderProbeCache(DecoderProbeBackend *backend, const QString &file = cacheFile());
+    static QString cacheFile();
+    // invalid if the stream of file is not probed.
+    DecodePath lookup(const QString &file);
+    // returns true if the path is different from the recorded one.
+    bool record(const QString &file, const DecodePath &path);
+protected:
+    void load();
+    void save() const;
+private:
+    QScopedPointer<DecoderProbeBackend> backend;
+    QString path;
+    QString driver;
+    bool loaded = false;
+    QHash<QString, DecodePath> paths;   // stream -- path
+};
+
+}
+
+#endif // DECODERPROBECACHE_H
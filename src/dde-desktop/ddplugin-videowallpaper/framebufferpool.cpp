@@ -0,0 +1,183 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef USE_LIBDMR
+
+#include "framebufferpool.h"
+
+#include <QMutexLocker>
+
+using namespace ddplugin_videowallpaper;
+
+// the frames held by consumers at the same time.
+static constexpr int kMaxBusyBuffers = 8;
+
+namespace ddplugin_videowallpaper {
+class FrameBuffer
+{
+public:
+    QVideoFrame frame;
+    QByteArray data;
+    FrameBufferPool *pool = nullptr;
+};
+}
+
+class FrameBufferPoolGlobal : public FrameBufferPool {};
+Q_GLOBAL_STATIC(FrameBufferPoolGlobal, frameBufferPool)
+
+FrameBufferPool *FrameBufferPool::instance()
+{
+    return frameBufferPool;
+}
+
+FrameBufferPool::FrameBufferPool()
+{
+
+}
+
+FrameBufferPool::~FrameBufferPool()
+{
+    qDeleteAll(idle);
+    idle.clear();
+}
+
+QImage FrameBufferPool::wrap(const QVideoFrame &frame)
+{
+    const QImage::Format fmt = QVideoFrame::imageFormatFromPixelFormat(frame.pixelFormat());
+    if (fmt == QImage::Format_Invalid)
+        return QImage();
+
+    FrameBuffer *buf = take();
+
+    // all buffers are held by consumers, copy the frame.
+    if (!buf) {
+        QVideoFrame clone(frame);
+        if (!clone.map(QAbstractVideoBuffer::ReadOnly))
+            return QImage();
+
+        QImage img = QImage(clone.bits(), clone.width(), clone.height(), clone.bytesPerLine(), fmt).copy();
+        clone.unmap();
+        countCopy(img.sizeInBytes());
+        return img;
+    }
+
+    buf->frame = frame;
+    if (!buf->frame.map(QAbstractVideoBuffer::ReadOnly)) {
+        release(buf);
+        return QImage();
+    }
+
+    {
+        QMutexLocker lk(&mtx);
+        stat.shared++;
+    }
+
+    return QImage(buf->frame.bits(), buf->frame.width(), buf->frame.height(),
+                  buf->frame.bytesPerLine(), fmt, &FrameBufferPool::release, buf);
+}
+
+QImage FrameBufferPool::allocate(const QSize &size, QImage::Format format)
+{
+    const int bytesPerLine = ((size.width() * QImage::toPixelFormat(format).bitsPerPixel() + 31) >> 5) << 2;
+    const int bytes = bytesPerLine * size.height();
+    if (bytes <= 0)
+        return QImage();
+
+    FrameBuffer *buf = take();
+    if (!buf) {
+        countAllocation(bytes);
+        return QImage(size, format);
+    }
+
+    // a recycled buffer is reallocated only if it is too small.
+    if (buf->data.size() < bytes) {
+        buf->data.resize(bytes);
+        countAllocation(bytes);
+    }
+
+    return QImage(reinterpret_cast<uchar *>(buf->data.data()), size.width(), size.height(),
+                  bytesPerLine, format, &FrameBufferPool::release, buf);
+}
+
+qint64 FrameBufferPool::trim()
+{
+    QList<FrameBuffer *> bufs;
+    {
+        QMutexLocker lk(&mtx);
+        bufs.swap(idle);
+    }
+
+    qint64 bytes = 0;
+    for (FrameBuffer *buf : bufs)
+        bytes += buf->data.capacity();
+    qDeleteAll(bufs);
+    return bytes;
+}
+
+qint64 FrameBufferPool::idleBytes() const
+{
+    QMutexLocker lk(&mtx);
+    qint64 bytes = 0;
+    for (FrameBuffer *buf : idle)
+        bytes += buf->data.capacity();
+    return bytes;
+}
+
+FrameCounters FrameBufferPool::counters() const
+{
+    QMutexLocker lk(&mtx);
+    return stat;
+}
+
+void FrameBufferPool::countCopy(qint64 bytes)
+{
+    QMutexLocker lk(&mtx);
+    stat.copied++;
+    stat.copiedBytes += bytes;
+}
+
+void FrameBufferPool::countFrame()
+{
+    QMutexLocker lk(&mtx);
+    stat.frames++;
+}
+
+void FrameBufferPool::countAllocation(qint64 bytes)
+{
+    QMutexLocker lk(&mtx);
+    stat.allocations++;
+    stat.allocatedBytes += static_cast<quint64>(bytes);
+}
+
+FrameBuffer *FrameBufferPool::take()
+{
+    QMutexLocker lk(&mtx);
+    if (busy >= kMaxBusyBuffers)
+        return nullptr;
+
+    busy++;
+    if (!idle.isEmpty())
+        return idle.takeLast();
+
+    // the pixels are allocated by allocate() or mapped by wrap(), not here.
+    FrameBuffer *buf = new FrameBuffer;
+    buf->pool = this;
+    return buf;
+}
+
+void FrameBufferPool::release(void *buffer)
+{
+    // called by the last QImage referring the buffer, maybe in any thread.
+    FrameBuffer *buf = static_cast<FrameBuffer *>(buffer);
+    if (buf->frame.isMapped())
+        buf->frame.unmap();
+    buf->frame = QVideoFrame();
+
+    FrameBufferPool *pool = buf->pool;
+    QMutexLocker lk(&pool->mtx);
+    pool->busy--;
+    pool->idle.append(buf);
+}
+
+#endif
@@ -0,0 +1,57 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef FRAMEBUFFERPOOL_H
+#define FRAMEBUFFERPOOL_H
+
+#ifndef USE_LIBDMR
+#include <QVideoFrame>
+#include <QImage>
+#include <QMutex>
+
+namespace ddplugin_videowallpaper {
+
+struct FrameCounters
+{
+    quint64 frames = 0;        // frames handed to consumers
+    quint64 shared = 0;        // frames handed without copying
+    quint64 copied = 0;        // frames copied because no buffer was free
+    quint64 copiedBytes = 0;
+    quint64 allocations = 0;   // pixel buffers allocated or grown by the pool
+    quint64 allocatedBytes = 0;
+};
+
+class FrameBuffer;
+class FrameBufferPool
+{
+public:
+    static FrameBufferPool *instance();
+    // the image refers to the mapped frame, which is unmapped and recycled
+    // after the last copy of the image is destroyed.
+    QImage wrap(const QVideoFrame &frame);
+    // a recycled image to write converted frames.
+    QImage allocate(const QSize &size, QImage::Format format);
+    FrameCounters counters() const;
+    void countCopy(qint64 bytes);
+    // called once for each frame handed to consumers.
+    void countFrame();
+    // frees the idle buffers and returns their bytes.
+    qint64 trim();
+    qint64 idleBytes() const;
+protected:
+    FrameBufferPool();
+    ~FrameBufferPool();
+    static void release(void *buffer);
+    FrameBuffer *take();
+    void countAllocation(qint64 bytes);
+private:
+    mutable QMutex mtx;
+    QList<FrameBuffer *> idle;
+    int busy = 0;
+    FrameCounters stat;
+};
+
+}
+#endif
+#endif // FRAMEBUFFERPOOL_H
@@ -0,0 +1,42 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "framelimiter.h"
+
+using namespace ddplugin_videowallpaper;
+
+void FrameLimiter::setMaxFps(int f)
+{
+    fps = qMax(f, 0);
+    interval = fps > 0 ? 1000000 / fps : 0;
+    reset();
+}
+
+int FrameLimiter::maxFps() const
+{
+    return fps;
+}
+
+bool FrameLimiter::accept(qint64 time)
+{
+    if (interval <= 0)
+        return true;
+
+    // tolerate the jitter of frame arrival.
+    if (next >= 0 && time + interval / 4 < next)
+        return false;
+
+    // restart the schedule if frames were not coming for a while.
+    if (next < 0 || time - next > interval)
+        next = time + interval;
+    else
+        next += interval;
+
+    return true;
+}
+
+void FrameLimiter::reset()
+{
+    next = -1;
+}
@@ -0,0 +1,29 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef FRAMELIMITER_H
+#define FRAMELIMITER_H
+
+#include <QtGlobal>
+
+namespace ddplugin_videowallpaper {
+
+class FrameLimiter
+{
+public:
+    // fps less than 1 means no limit.
+    void setMaxFps(int fps);
+    int maxFps() const;
+    // time is in microseconds and must be monotonic.
+    bool accept(qint64 time);
+    void reset();
+private:
+    int fps = 0;
+    qint64 interval = 0;
+    qint64 next = -1;
+};
+
+}
+
+#endif // FRAMELIMITER_H
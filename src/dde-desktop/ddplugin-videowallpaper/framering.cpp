@@ -0,0 +1,205 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "framering.h"
+#include "ddplugin_videowallpaper_global.h"
+
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+
+using namespace ddplugin_videowallpaper;
+
+static QByteArray compressFrame(const uchar *src, int size)
+{
+#ifdef USE_LZ4
+    QByteArray ret(LZ4_compressBound(size), Qt::Uninitialized);
+    int len = LZ4_compress_default(reinterpret_cast<const char *>(src), ret.data(), size, ret.size());
+    if (len <= 0)
+        return QByteArray();
+    ret.resize(len);
+    ret.squeeze();
+    return ret;
+#else
+    // the fastest level of zlib.
+    return qCompress(src, size, 1);
+#endif
+}
+
+static bool decompressFrame(const QByteArray &src, uchar *dst, int size)
+{
+#ifdef USE_LZ4
+    return LZ4_decompress_safe(src.constData(), reinterpret_cast<char *>(dst), src.size(), size) == size;
+#else
+    const QByteArray raw = qUncompress(src);
+    if (raw.size() != size)
+        return false;
+    memcpy(dst, raw.constData(), static_cast<size_t>(size));
+    return true;
+#endif
+}
+
+FrameRing::FrameRing(QObject *parent) : QObject(parent)
+{
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::PreciseTimer);
+    connect(&timer, &QTimer::timeout, this, &FrameRing::tick);
+}
+
+void FrameRing::setBudget(qint64 b)
+{
+    limit = qMax(b, qint64(0));
+    if (stat != kIdle && total > limit)
+        evict();
+}
+
+qint64 FrameRing::budget() const
+{
+    return limit;
+}
+
+qint64 FrameRing::bytes() const
+{
+    return total;
+}
+
+int FrameRing::count() const
+{
+    return frames.size();
+}
+
+FrameRing::State FrameRing::state() const
+{
+    return stat;
+}
+
+void FrameRing::start()
+{
+    clear();
+    stat = kRecording;
+}
+
+bool FrameRing::append(const QImage &img, qint64 pts)
+{
+    if (stat != kRecording || img.isNull())
+        return false;
+
+    // all frames in one loop have the same layout.
+    if (frames.isEmpty()) {
+        size = img.size();
+        format = img.format();
+        bytesPerLine = img.bytesPerLine();
+    } else if (img.size() != size || img.format() != format || img.bytesPerLine() != bytesPerLine) {
+        clear();
+        return false;
+    }
+
+    // out of order frame.
+    if (!frames.isEmpty() && pts <= frames.last().pts)
+        return true;
+
+    Frame frame;
+    frame.pts = pts;
+    frame.data = compressFrame(img.constBits(), static_cast<int>(img.sizeInBytes()));
+    if (frame.data.isEmpty()) {
+        clear();
+        return false;
+    }
+
+    total += frame.data.size();
+    frames.append(frame);
+    if (total > limit) {
+        evict();
+        return false;
+    }
+
+    return true;
+}
+
+bool FrameRing::finish(qint64 duration)
+{
+    if (stat != kRecording || frames.size() < 2) {
+        clear();
+        return false;
+    }
+
+    loop = qMax(duration, frames.last().pts + 1);
+    stat = kReady;
+    fmInfo() << "frame ring is ready," << frames.size() << "frames" << total / 1024 << "KiB for" << loop << "ms";
+    return true;
+}
+
+void FrameRing::clear()
+{
+    timer.stop();
+    frames.clear();
+    frames.squeeze();
+    total = 0;
+    loop = 0;
+    index = 0;
+    stat = kIdle;
+}
+
+void FrameRing::play()
+{
+    if (stat != kReady || timer.isActive())
+        return;
+
+    tick();
+}
+
+void FrameRing::stop()
+{
+    timer.stop();
+}
+
+bool FrameRing::isPlaying() const
+{
+    return timer.isActive();
+}
+
+quint64 FrameRing::evictions() const
+{
+    return evictCount;
+}
+
+void FrameRing::tick()
+{
+    if (stat != kReady || frames.isEmpty())
+        return;
+
+    if (index >= frames.size())
+        index = 0;
+
+    QImage img = frameAt(index);
+    if (img.isNull()) {
+        evict();
+        return;
+    }
+
+    const qint64 pts = frames.at(index).pts;
+    index++;
+    // the gap to the first frame of next loop.
+    const qint64 next = index < frames.size() ? frames.at(index).pts : loop + frames.first().pts;
+    timer.start(static_cast<int>(qMax(next - pts, qint64(1))));
+
+    emit frameReady(img);
+}
+
+QImage FrameRing::frameAt(int idx) const
+{
+    QImage img(size, format);
+    if (img.bytesPerLine() != bytesPerLine
+            || !decompressFrame(frames.at(idx).data, img.bits(), static_cast<int>(img.sizeInBytes())))
+        return QImage();
+    return img;
+}
+
+void FrameRing::evict()
+{
+    fmInfo() << "frame ring is evicted," << total / 1024 << "KiB exceeds the budget" << limit / 1024 << "KiB";
+    clear();
+    evictCount++;
+    emit evicted();
+}
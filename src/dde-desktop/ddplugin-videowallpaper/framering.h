@@ -0,0 +1,66 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef FRAMERING_H
+#define FRAMERING_H
+
+#include <QObject>
+#include <QImage>
+#include <QTimer>
+#include <QVector>
+
+namespace ddplugin_videowallpaper {
+
+// keeps the compressed frames of one loop of a short clip and plays them without decoder.
+class FrameRing : public QObject
+{
+    Q_OBJECT
+public:
+    enum State { kIdle, kRecording, kReady };
+    explicit FrameRing(QObject *parent = nullptr);
+    void setBudget(qint64 bytes);
+    qint64 budget() const;
+    qint64 bytes() const;
+    int count() const;
+    State state() const;
+    void start();
+    // pts is in milliseconds. returns false if the ring is evicted for exceeding budget.
+    bool append(const QImage &img, qint64 pts);
+    // duration of the loop in milliseconds.
+    bool finish(qint64 duration);
+    void clear();
+    void play();
+    void stop();
+    bool isPlaying() const;
+    quint64 evictions() const;
+signals:
+    void frameReady(const QImage &img);
+    void evicted();
+protected slots:
+    void tick();
+protected:
+    QImage frameAt(int idx) const;
+    void evict();
+private:
+    struct Frame
+    {
+        QByteArray data;
+        qint64 pts = 0;
+    };
+    State stat = kIdle;
+    QVector<Frame> frames;
+    QSize size;
+    QImage::Format format = QImage::Format_Invalid;
+    int bytesPerLine = 0;
+    qint64 total = 0;
+    qint64 limit = 0;
+    qint64 loop = 0;
+    int index = 0;
+    quint64 evictCount = 0;
+    QTimer timer;
+};
+
+}
+
+#endif // FRAMERING_H
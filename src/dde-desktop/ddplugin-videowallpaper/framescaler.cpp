@@ -0,0 +1,171 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "framescaler.h"
+
+#include <QtConcurrent>
+#include <QElapsedTimer>
+
+using namespace ddplugin_videowallpaper;
+
+FrameScaler::FrameScaler(QObject *parent) : QObject(parent)
+{
+    pool.setMaxThreadCount(2);
+}
+
+FrameScaler::~FrameScaler()
+{
+    pending.clear();
+    for (QFutureWatcher<QImage> *watcher : running.values()) {
+        watcher->disconnect(this);
+        watcher->waitForFinished();
+        delete watcher;
+    }
+    running.clear();
+    runningJobs.clear();
+}
+
+void FrameScaler::setMode(ScaleMode mode)
+{
+    if (scaleMode == mode)
+        return;
+
+    scaleMode = mode;
+    geometries.clear();
+}
+
+ScaleMode FrameScaler::mode() const
+{
+    return scaleMode;
+}
+
+ScaleGeometry FrameScaler::geometry(const QSize &frame, const QSize &target)
+{
+    const QString key = QString("%0x%1:%2x%3").arg(frame.width()).arg(frame.height())
+            .arg(target.width()).arg(target.height());
+    auto itor = geometries.find(key);
+    if (itor != geometries.end())
+        return itor.value();
+
+    // the sizes are changed rarely, do not let it grow.
+    if (geometries.size() > 32)
+        geometries.clear();
+
+    ScaleGeometry geo = ScaleGeometry::compute(frame, target, scaleMode);
+    geometries.insert(key, geo);
+    return geo;
+}
+
+void FrameScaler::scale(const QImage &img, const QList<VideoProxyPointer> &targets, const QRectF &region)
+{
+    if (img.isNull() || region.isEmpty())
+        return;
+
+    // the size of full frame that img is a part of.
+    const QSize frame(qRound(img.width() / region.width()), qRound(img.height() / region.height()));
+    const QPoint offset(qRound(region.x() * frame.width()), qRound(region.y() * frame.height()));
+
+    // the widgets having same size and device pixel ratio use the same scaled image.
+    QMap<QString, Job> jobs;
+    for (const VideoProxyPointer &bwp : targets) {
+        const QSize size = bwp->frameSize();
+        if (size.isEmpty())
+            continue;
+
+        const qreal ratio = bwp->devicePixelRatioF();
+        QString key = QString("%0x%1@%2").arg(size.width()).arg(size.height()).arg(ratio);
+        ScaleGeometry geo;
+        const QRectF span = bwp->spanRegion();
+        if (span.isEmpty()) {
+            geo = geometry(frame, size);
+        } else {
+            // each spanned screen shows its own part of the frame.
+            geo.source = QRectF(span.x() * frame.width(), span.y() * frame.height(),
+                                span.width() * frame.width(), span.height() * frame.height()).toAlignedRect();
+            geo.target = size;
+            key.append(QString(":%0,%1,%2,%3").arg(geo.source.x()).arg(geo.source.y())
+                       .arg(geo.source.width()).arg(geo.source.height()));
+        }
+
+        Job &job = jobs[key];
+        job.source = img;
+        job.crop = geo.source.translated(-offset).intersected(img.rect());
+        job.size = geo.target;
+        job.ratio = ratio;
+        job.widgets.append(bwp.get());
+        job.counters.append(bwp->counters());
+    }
+
+    for (auto itor = jobs.begin(); itor != jobs.end(); ++itor) {
+        // drop the older frame if the last one is not finished.
+        if (running.contains(itor.key())) {
+            if (pending.contains(itor.key())) {
+                for (StageCounters *counters : pending.value(itor.key()).counters)
+                    counters->dropped.fetchAndAddRelaxed(1);
+            }
+            pending.insert(itor.key(), itor.value());
+        } else
+            start(itor.key(), itor.value());
+    }
+}
+
+void FrameScaler::start(const QString &key, const Job &job)
+{
+    auto watcher = new QFutureWatcher<QImage>(this);
+    running.insert(key, watcher);
+    runningJobs.insert(key, job);
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, key]() {
+        finish(key);
+    });
+
+    const QImage source = job.source;
+    const QRect crop = job.crop;
+    const QSize size = job.size;
+    const qreal ratio = job.ratio;
+    const QList<StageCounters *> counters = job.counters;
+    watcher->setFuture(QtConcurrent::run(&pool, [source, crop, size, ratio, counters]() {
+        QElapsedTimer timer;
+        timer.start();
+        QImage img;
+        if (crop == source.rect()) {
+            img = source.scaled(size, Qt::IgnoreAspectRatio);
+        } else if (source.depth() == 32) {
+            // refer to the visible region without copying.
+            const uchar *bits = source.constBits() + crop.y() * source.bytesPerLine() + crop.x() * 4;
+            QImage view(bits, crop.width(), crop.height(), source.bytesPerLine(), source.format());
+            // the view must not be kept after source is released.
+            img = crop.size() == size ? view.copy() : view.scaled(size, Qt::IgnoreAspectRatio);
+        } else {
+            img = source.copy(crop).scaled(size, Qt::IgnoreAspectRatio);
+        }
+
+        img.setDevicePixelRatio(ratio);
+
+        const qint64 ns = timer.nsecsElapsed();
+        for (StageCounters *c : counters) {
+            c->scale.add(ns);
+            c->allocatedBytes.fetchAndAddRelaxed(static_cast<quint64>(img.sizeInBytes()));
+        }
+        return img;
+    }));
+}
+
+void FrameScaler::finish(const QString &key)
+{
+    QFutureWatcher<QImage> *watcher = running.take(key);
+    Job job = runningJobs.take(key);
+    if (!watcher)
+        return;
+
+    const QImage img = watcher->result();
+    watcher->deleteLater();
+
+    for (const QPointer<VideoProxy> &wid : job.widgets) {
+        if (wid)
+            wid->updateImage(img);
+    }
+
+    if (pending.contains(key))
+        start(key, pending.take(key));
+}
@@ -0,0 +1,54 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef FRAMESCALER_H
+#define FRAMESCALER_H
+
+#include "videoproxy.h"
+#include "scalemode.h"
+
+#include <QObject>
+#include <QPointer>
+#include <QThreadPool>
+#include <QFutureWatcher>
+
+namespace ddplugin_videowallpaper {
+
+class FrameScaler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FrameScaler(QObject *parent = nullptr);
+    ~FrameScaler() override;
+    void setMode(ScaleMode mode);
+    ScaleMode mode() const;
+    // scale img in worker threads once for each size of targets.
+    // region is the part of full frame in img, normalized to 0~1.
+    void scale(const QImage &img, const QList<VideoProxyPointer> &targets,
+               const QRectF &region = QRectF(0, 0, 1, 1));
+protected:
+    ScaleGeometry geometry(const QSize &frame, const QSize &target);
+    struct Job
+    {
+        QImage source;
+        QRect crop;   // the visible region in source
+        QSize size;
+        qreal ratio = 1;
+        QList<QPointer<VideoProxy>> widgets;
+        QList<StageCounters *> counters;
+    };
+    void start(const QString &key, const Job &job);
+    void finish(const QString &key);
+private:
+    QThreadPool pool;
+    QMap<QString, QFutureWatcher<QImage> *> running;   // size -- scaling job
+    QMap<QString, Job> runningJobs;
+    QMap<QString, Job> pending;   // the latest frame waiting for the running job
+    ScaleMode scaleMode = kScaleFit;
+    QHash<QString, ScaleGeometry> geometries;   // computed once for each size
+};
+
+}
+
+#endif // FRAMESCALER_H
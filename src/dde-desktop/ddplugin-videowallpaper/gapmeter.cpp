@@ -0,0 +1,65 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "gapmeter.h"
+#include "ddplugin_videowallpaper_global.h"
+
+using namespace ddplugin_videowallpaper;
+
+void GapMeter::start()
+{
+    timer.start();
+}
+
+bool GapMeter::isRunning() const
+{
+    return timer.isValid();
+}
+
+qreal GapMeter::finish(qreal frameInterval)
+{
+    if (!timer.isValid())
+        return 0;
+
+    lastGap = timer.nsecsElapsed() / 1e6;
+    timer.invalidate();
+
+    maxGap = qMax(maxGap, lastGap);
+    total += lastGap;
+    transitions++;
+
+    if (frameInterval > 0 && lastGap > frameInterval) {
+        slow++;
+        fmWarning() << "transition gap" << lastGap << "ms is longer than one frame" << frameInterval << "ms";
+    } else {
+        fmDebug() << "transition gap" << lastGap << "ms";
+    }
+
+    return lastGap;
+}
+
+qreal GapMeter::last() const
+{
+    return lastGap;
+}
+
+qreal GapMeter::max() const
+{
+    return maxGap;
+}
+
+qreal GapMeter::average() const
+{
+    return transitions > 0 ? total / transitions : 0;
+}
+
+quint64 GapMeter::count() const
+{
+    return transitions;
+}
+
+quint64 GapMeter::overruns() const
+{
+    return slow;
+}
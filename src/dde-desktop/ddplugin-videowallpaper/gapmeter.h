@@ -0,0 +1,36 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef GAPMETER_H
+#define GAPMETER_H
+
+#include <QElapsedTimer>
+
+namespace ddplugin_videowallpaper {
+
+// measures the time between the end of an item and the first frame of the next one.
+class GapMeter
+{
+public:
+    void start();
+    bool isRunning() const;
+    // frameInterval is in milliseconds, the gap is returned in milliseconds.
+    qreal finish(qreal frameInterval);
+    qreal last() const;
+    qreal max() const;
+    qreal average() const;
+    quint64 count() const;
+    quint64 overruns() const;
+private:
+    QElapsedTimer timer;
+    qreal lastGap = 0;
+    qreal maxGap = 0;
+    qreal total = 0;
+    quint64 transitions = 0;
+    quint64 slow = 0;   // the gaps longer than one frame
+};
+
+}
+
+#endif // GAPMETER_H
@@ -0,0 +1,329 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "mediaindex.h"
+#include "ddplugin_videowallpaper_global.h"
+
+#include <QtConcurrent>
+#include <QCollator>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMimeDatabase>
+#include <QProcess>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+using namespace ddplugin_videowallpaper;
+
+static constexpr int kIndexVersion = 2;
+static constexpr int kProbeTimeout = 10000;   // ms
+static constexpr int kScanDelay = 1000;   // ms
+// a file modified in this time may be still being written.
+static constexpr int kSettleTime = 3000;   // ms
+
+MediaIndex::MediaIndex(QObject *parent) : QObject(parent)
+{
+    delayTimer.setSingleShot(true);
+    connect(&delayTimer, &QTimer::timeout, this, [this]() {
+        scan(directories);
+    });
+}
+
+MediaIndex::~MediaIndex()
+{
+    if (watcher) {
+        watcher->disconnect(this);
+        watcher->waitForFinished();
+        delete watcher;
+        watcher = nullptr;
+    }
+}
+
+QString MediaIndex::indexFile()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/deepin/dde-desktop/video-wallpaper-index.json";
+}
+
+QList<QUrl> MediaIndex::videos() const
+{
+    return videos(QString());
+}
+
+QList<QUrl> MediaIndex::videos(const QString &dir) const
+{
+    const QString prefix = dir.isEmpty() ? QString() : QDir(dir).absolutePath() + "/";
+    QStringList files;
+    for (const MediaInfo &info : index.values()) {
+        // not in the sub directories.
+        if (info.playable && (prefix.isEmpty()
+                              || (info.path.startsWith(prefix) && !info.path.midRef(prefix.size()).contains('/'))))
+            files.append(info.path);
+    }
+
+    QCollator collator;
+    collator.setNumericMode(true);
+    std::sort(files.begin(), files.end(), collator);
+
+    QList<QUrl> ret;
+    for (const QString &file : files)
+        ret.append(QUrl::fromLocalFile(file));
+    return ret;
+}
+
+MediaInfoMap MediaIndex::entries() const
+{
+    return index;
+}
+
+bool MediaIndex::isScanning() const
+{
+    return watcher != nullptr;
+}
+
+bool MediaIndex::isReady() const
+{
+    return ready;
+}
+
+void MediaIndex::scheduleScan(const QStringList &dirs)
+{
+    directories = dirs;
+    delayTimer.start(kScanDelay);
+}
+
+void MediaIndex::scan(const QStringList &dirs)
+{
+    delayTimer.stop();
+    directories = dirs;
+    if (watcher) {
+        pending = dirs;
+        return;
+    }
+
+    // the saved index is loaded by the first scanning.
+    const bool first = !loaded;
+    loaded = true;
+
+    watcher = new QFutureWatcher<ScanResult>(this);
+    connect(watcher, &QFutureWatcher<ScanResult>::finished, this, &MediaIndex::finished);
+    const MediaInfoMap old = index;
+    watcher->setFuture(QtConcurrent::run([dirs, old, first]() {
+        return MediaIndex::scanDirs(dirs, first ? MediaIndex::load() : old);
+    }));
+}
+
+MediaIndex::ScanResult MediaIndex::scanDirs(const QStringList &dirs, MediaInfoMap old)
+{
+    ScanResult ret;
+    bool changed = false;
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QFileInfoList files;
+    for (const QString &dir : dirs)
+        files.append(QDir(dir).entryInfoList(QDir::Files));
+
+    for (const QFileInfo &file : files) {
+        const QString path = file.absoluteFilePath();
+        if (ret.index.contains(path))
+            continue;
+
+        const qint64 mtime = file.lastModified().toMSecsSinceEpoch();
+        auto itor = old.find(path);
+        if (itor != old.end() && itor->size == file.size() && itor->mtime == mtime) {
+            ret.index.insert(path, itor.value());
+            old.erase(itor);
+            continue;
+        }
+
+        // probe it after writing, the old info is kept until then.
+        if (now - mtime < kSettleTime) {
+            ret.unsettled = true;
+            if (itor != old.end()) {
+                ret.index.insert(path, itor.value());
+                old.erase(itor);
+            }
+            continue;
+        }
+
+        MediaInfo info = probe(path);
+        info.size = file.size();
+        info.mtime = mtime;
+        ret.index.insert(path, info);
+        if (itor != old.end())
+            old.erase(itor);
+        changed = true;
+        fmInfo() << "probe" << path << info.playable << info.container << info.codec << info.resolution << info.duration;
+    }
+
+    if (changed || !old.isEmpty())
+        save(ret.index);
+    return ret;
+}
+
+MediaInfo MediaIndex::probe(const QString &file)
+{
+    MediaInfo info;
+    info.path = file;
+
+    // skip the files which are obviously not video, such as text, images and partial downloads.
+    static const QStringList kPartial { "part", "crdownload", "download", "tmp" };
+    if (kPartial.contains(QFileInfo(file).suffix(), Qt::CaseInsensitive))
+        return info;
+
+    const QMimeType mime = QMimeDatabase().mimeTypeForFile(file);
+    const bool isVideo = mime.name().startsWith("video/") || mime.inherits("application/vnd.rn-realmedia");
+    // the unknown binary file is probed too.
+    if (!isVideo && !mime.isDefault())
+        return info;
+
+    // ffmpeg is only recommended, do not try to start ffprobe for each file without it.
+    static const bool hasProbe = !QStandardPaths::findExecutable("ffprobe").isEmpty();
+    if (!hasProbe) {
+        info.playable = isVideo;
+        return info;
+    }
+
+    QProcess ffprobe;
+    ffprobe.start("ffprobe", { "-v", "error", "-select_streams", "v:0",
+                              "-show_entries", "format=format_name,duration:stream=codec_name,profile,width,height",
+                              "-of", "json", file });
+    if (!ffprobe.waitForStarted()) {
+        // no ffprobe, trust the mime type.
+        info.playable = isVideo;
+        return info;
+    }
+
+    if (!ffprobe.waitForFinished(kProbeTimeout)) {
+        ffprobe.kill();
+        ffprobe.waitForFinished();
+        return info;
+    }
+
+    if (ffprobe.exitStatus() != QProcess::NormalExit || ffprobe.exitCode() != 0)
+        return info;
+
+    const QJsonObject root = QJsonDocument::fromJson(ffprobe.readAllStandardOutput()).object();
+    const QJsonObject format = root.value("format").toObject();
+    const QJsonArray streams = root.value("streams").toArray();
+    if (streams.isEmpty())
+        return info;
+
+    const QJsonObject stream = streams.first().toObject();
+    info.container = format.value("format_name").toString();
+    info.duration = qRound64(format.value("duration").toString().toDouble() * 1000);
+    info.codec = stream.value("codec_name").toString();
+    info.profile = stream.value("profile").toString();
+    info.resolution = QSize(stream.value("width").toInt(), stream.value("height").toInt());
+
+    // a still image is probed as a video stream without duration.
+    info.playable = !info.codec.isEmpty() && !info.resolution.isEmpty() && info.duration > 0;
+    return info;
+}
+
+MediaInfoMap MediaIndex::load()
+{
+    MediaInfoMap ret;
+    QFile file(indexFile());
+    if (!file.open(QFile::ReadOnly))
+        return ret;
+
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    if (root.value("version").toInt() != kIndexVersion)
+        return ret;
+
+    for (const QJsonValue &val : root.value("files").toArray()) {
+        const QJsonObject obj = val.toObject();
+        MediaInfo info;
+        info.path = obj.value("path").toString();
+        info.size = static_cast<qint64>(obj.value("size").toDouble());
+        info.mtime = static_cast<qint64>(obj.value("mtime").toDouble());
+        info.container = obj.value("container").toString();
+        info.codec = obj.value("codec").toString();
+        info.profile = obj.value("profile").toString();
+        info.resolution = QSize(obj.value("width").toInt(), obj.value("height").toInt());
+        info.duration = static_cast<qint64>(obj.value("duration").toDouble());
+        info.playable = obj.value("playable").toBool();
+        if (!info.path.isEmpty())
+            ret.insert(info.path, info);
+    }
+
+    return ret;
+}
+
+void MediaIndex::save(const MediaInfoMap &map)
+{
+    QJsonArray files;
+    for (const MediaInfo &info : map.values()) {
+        QJsonObject obj;
+        obj.insert("path", info.path);
+        obj.insert("size", static_cast<double>(info.size));
+        obj.insert("mtime", static_cast<double>(info.mtime));
+        obj.insert("container", info.container);
+        obj.insert("codec", info.codec);
+        obj.insert("profile", info.profile);
+        obj.insert("width", info.resolution.width());
+        obj.insert("height", info.resolution.height());
+        obj.insert("duration", static_cast<double>(info.duration));
+        obj.insert("playable", info.playable);
+        files.append(obj);
+    }
+
+    QJsonObject root;
+    root.insert("version", kIndexVersion);
+    root.insert("files", files);
+
+    QFileInfo(indexFile()).absoluteDir().mkpath(".");
+    QSaveFile file(indexFile());
+    if (!file.open(QFile::WriteOnly)) {
+        fmWarning() << "can not write media index" << indexFile();
+        return;
+    }
+
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    file.commit();
+}
+
+void MediaIndex::finished()
+{
+    const ScanResult result = watcher->result();
+    watcher->deleteLater();
+    watcher = nullptr;
+
+    // only the playable files are concerned.
+    MediaDiff diff;
+    for (const MediaInfo &info : result.index.values()) {
+        if (!info.playable)
+            continue;
+
+        auto itor = index.find(info.path);
+        if (itor == index.end() || !itor->playable)
+            diff.added.append(info.path);
+        else if (itor->size != info.size || itor->mtime != info.mtime)
+            diff.modified.append(info.path);
+    }
+
+    for (const MediaInfo &info : index.values()) {
+        if (info.playable && !result.index.value(info.path).playable)
+            diff.removed.append(info.path);
+    }
+
+    index = result.index;
+    ready = true;
+    if (!diff.isEmpty())
+        fmInfo() << "media changed, added" << diff.added << "removed" << diff.removed << "modified" << diff.modified;
+
+    emit updated(diff);
+
+    if (!pending.isEmpty()) {
+        const QStringList dirs = pending;
+        pending.clear();
+        scan(dirs);
+    } else if (result.unsettled && !delayTimer.isActive()) {
+        delayTimer.start(kSettleTime);
+    }
+}
@@ -0,0 +1,88 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef MEDIAINDEX_H
+#define MEDIAINDEX_H
+
+#include <QObject>
+#include <QUrl>
+#include <QSize>
+#include <QHash>
+#include <QFutureWatcher>
+#include <QTimer>
+
+namespace ddplugin_videowallpaper {
+
+struct MediaInfo
+{
+    QString path;
+    qint64 size = 0;
+    qint64 mtime = 0;
+    QString container;
+    QString codec;
+    QString profile;
+    QSize resolution;
+    qint64 duration = 0;   // ms
+    bool playable = false;
+};
+
+typedef QHash<QString, MediaInfo> MediaInfoMap;   // path -- info
+
+struct MediaDiff
+{
+    QStringList added;
+    QStringList removed;
+    QStringList modified;
+    inline bool isEmpty() const
+    {
+        return added.isEmpty() && removed.isEmpty() && modified.isEmpty();
+    }
+};
+
+// probes the files in source directories in background and keeps the result in cache.
+class MediaIndex : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MediaIndex(QObject *parent = nullptr);
+    ~MediaIndex() override;
+    static QString indexFile();
+    // the files probed as video, sorted by name.
+    QList<QUrl> videos() const;
+    // the videos in dir only.
+    QList<QUrl> videos(const QString &dir) const;
+    MediaInfoMap entries() const;
+    bool isScanning() const;
+    // the first scanning is finished, the index is empty before it.
+    bool isReady() const;
+    static MediaInfo probe(const QString &file);
+public slots:
+    void scan(const QStringList &dirs);
+    // coalesces the changes in a short time into one scanning.
+    void scheduleScan(const QStringList &dirs);
+signals:
+    void updated(const MediaDiff &diff);
+protected:
+    struct ScanResult
+    {
+        MediaInfoMap index;
+        bool unsettled = false;   // some files are still being written.
+    };
+    static ScanResult scanDirs(const QStringList &dirs, MediaInfoMap old);
+    static MediaInfoMap load();
+    static void save(const MediaInfoMap &map);
+    void finished();
+private:
+    MediaInfoMap index;
+    bool loaded = false;
+    bool ready = false;
+    QFutureWatcher<ScanResult> *watcher = nullptr;
+    QStringList pending;   // the directories to scan after the running one
+    QStringList directories;
+    QTimer delayTimer;
+};
+
+}
+
+#endif // MEDIAINDEX_H
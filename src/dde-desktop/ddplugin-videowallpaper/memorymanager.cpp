@@ -0,0 +1,127 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "memorymanager.h"
+#include "perfcounters.h"
+#include "ddplugin_videowallpaper_global.h"
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+using namespace ddplugin_videowallpaper;
+
+static constexpr int kCheckInterval = 10000;   // ms
+// the limit is recovered below this percent of it.
+static constexpr int kRecoverPercent = 90;
+
+MemoryManager::MemoryManager(QObject *parent) : QObject(parent)
+{
+    checkTimer.setInterval(kCheckInterval);
+    connect(&checkTimer, &QTimer::timeout, this, &MemoryManager::check);
+}
+
+void MemoryManager::track(const QString &name, Counter held, Releaser release)
+{
+    holders.insert(name, Holder { held, release });
+}
+
+void MemoryManager::untrack(const QString &name)
+{
+    holders.remove(name);
+}
+
+void MemoryManager::setLimit(qint64 bytes)
+{
+    ceiling = qMax(bytes, qint64(0));
+    if (ceiling > 0) {
+        checkTimer.start();
+        check();
+    } else {
+        checkTimer.stop();
+        if (over) {
+            over = false;
+            emit limitRecovered();
+        }
+    }
+}
+
+qint64 MemoryManager::limit() const
+{
+    return ceiling;
+}
+
+bool MemoryManager::isOverLimit() const
+{
+    return over;
+}
+
+qint64 MemoryManager::held() const
+{
+    qint64 ret = 0;
+    for (const Holder &h : holders.values())
+        ret += h.held();
+    return ret;
+}
+
+QVariantMap MemoryManager::stats() const
+{
+    QVariantMap buffers;
+    for (auto itor = holders.begin(); itor != holders.end(); ++itor)
+        buffers.insert(itor.key(), itor.value().held());
+
+    QVariantMap ret;
+    ret.insert("resident", PerfCounters::residentBytes());
+    ret.insert("limit", ceiling);
+    ret.insert("overLimit", over);
+    ret.insert("buffers", buffers);
+    ret.insert("trims", trims);
+    ret.insert("freedBytes", freed);
+    return ret;
+}
+
+bool MemoryManager::releaseHeap()
+{
+#ifdef __GLIBC__
+    return malloc_trim(0) != 0;
+#else
+    return false;
+#endif
+}
+
+qint64 MemoryManager::trim()
+{
+    qint64 bytes = 0;
+    for (const Holder &h : holders.values()) {
+        if (h.release)
+            bytes += h.release();
+    }
+
+    releaseHeap();
+    trims++;
+    freed += bytes;
+    return bytes;
+}
+
+void MemoryManager::check()
+{
+    if (ceiling <= 0)
+        return;
+
+    const qint64 rss = PerfCounters::residentBytes();
+    if (rss > ceiling) {
+        // the caches are released first.
+        const qint64 bytes = trim();
+        const qint64 now = PerfCounters::residentBytes();
+        if (!over && now > ceiling) {
+            fmWarning() << "resident" << rss << "exceeds the limit" << ceiling << ", trimmed" << bytes << "to" << now;
+            over = true;
+            emit limitExceeded(now);
+        }
+    } else if (over && rss < ceiling / 100 * kRecoverPercent) {
+        fmInfo() << "resident" << rss << "is under the limit" << ceiling;
+        over = false;
+        emit limitRecovered();
+    }
+}
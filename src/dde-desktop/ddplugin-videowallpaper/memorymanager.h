@@ -0,0 +1,60 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef MEMORYMANAGER_H
+#define MEMORYMANAGER_H
+
+#include <QObject>
+#include <QMap>
+#include <QTimer>
+#include <QVariantMap>
+
+#include <functional>
+
+namespace ddplugin_videowallpaper {
+
+// tracks the frame buffers held by the plugin and keeps the resident size under the limit.
+class MemoryManager : public QObject
+{
+    Q_OBJECT
+public:
+    typedef std::function<qint64()> Counter;    // the bytes held
+    typedef std::function<qint64()> Releaser;   // releases the buffers and returns the bytes freed
+
+    explicit MemoryManager(QObject *parent = nullptr);
+    // the buffers without releaser are only counted.
+    void track(const QString &name, Counter held, Releaser release = nullptr);
+    void untrack(const QString &name);
+    // the resident bytes of process, 0 for no limit.
+    void setLimit(qint64 bytes);
+    qint64 limit() const;
+    bool isOverLimit() const;
+    qint64 held() const;
+    QVariantMap stats() const;
+    // returns the freed heap to system.
+    static bool releaseHeap();
+public slots:
+    // releases all tracked buffers which can be released.
+    qint64 trim();
+    void check();
+signals:
+    void limitExceeded(qint64 resident);
+    void limitRecovered();
+private:
+    struct Holder
+    {
+        Counter held;
+        Releaser release;
+    };
+    QMap<QString, Holder> holders;
+    qint64 ceiling = 0;
+    bool over = false;
+    QTimer checkTimer;
+    quint64 trims = 0;
+    qint64 freed = 0;
+};
+
+}
+
+#endif // MEMORYMANAGER_H
@@ -0,0 +1,145 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "occlusiontracker.h"
+#include "ddplugin_videowallpaper_global.h"
+
+#include <DWindowManagerHelper>
+
+#include <QRegion>
+
+DGUI_USE_NAMESPACE
+using namespace ddplugin_videowallpaper;
+
+// the gaps narrower than it between windows and screen edges are regarded as covered.
+static constexpr int kTolerance = 2;   // px
+
+WindowSource::WindowSource(QObject *parent) : AbstractWindowSource(parent)
+{
+    refreshTimer.setSingleShot(true);
+    refreshTimer.setInterval(0);
+    connect(&refreshTimer, &QTimer::timeout, this, &WindowSource::refresh);
+
+    DWindowManagerHelper *helper = DWindowManagerHelper::instance();
+    connect(helper, &DWindowManagerHelper::windowListChanged, this, &WindowSource::updateList);
+    // the windows got from the old window manager are invalid.
+    connect(helper, &DWindowManagerHelper::windowManagerChanged, this, [this]() {
+        clear();
+        updateList();
+    });
+    updateList();
+}
+
+WindowSource::~WindowSource()
+{
+    clear();
+}
+
+QList<QRect> WindowSource::windows() const
+{
+    return geometries;
+}
+
+void WindowSource::updateList()
+{
+    QMap<WId, DForeignWindow *> old = tracked;
+    tracked.clear();
+
+    // the existing windows are kept, only the new ones are created.
+    QList<DForeignWindow *> added;
+    for (quint32 wid : DWindowManagerHelper::instance()->currentWorkspaceWindowIdList()) {
+        DForeignWindow *win = old.take(wid);
+        if (!win) {
+            win = DForeignWindow::fromWinId(wid);
+            if (!win)
+                continue;
+            added.append(win);
+        }
+        tracked.insert(wid, win);
+    }
+
+    qDeleteAll(old);
+    for (DForeignWindow *win : added)
+        track(win);
+
+    refreshTimer.start();
+}
+
+void WindowSource::track(DForeignWindow *win)
+{
+    // the window list does not change when a window is maximized, moved or minimized.
+    connect(win, &QWindow::xChanged, &refreshTimer, qOverload<>(&QTimer::start));
+    connect(win, &QWindow::yChanged, &refreshTimer, qOverload<>(&QTimer::start));
+    connect(win, &QWindow::widthChanged, &refreshTimer, qOverload<>(&QTimer::start));
+    connect(win, &QWindow::heightChanged, &refreshTimer, qOverload<>(&QTimer::start));
+    connect(win, &QWindow::windowStateChanged, &refreshTimer, qOverload<>(&QTimer::start));
+}
+
+void WindowSource::clear()
+{
+    qDeleteAll(tracked);
+    tracked.clear();
+}
+
+void WindowSource::refresh()
+{
+    QList<QRect> rects;
+    for (DForeignWindow *win : tracked.values()) {
+        if (win->windowState() == Qt::WindowMinimized || win->wmClass() == "dde-desktop")
+            continue;
+        rects.append(win->frameGeometry());
+    }
+
+    if (rects != geometries) {
+        geometries = rects;
+        emit windowsChanged();
+    }
+}
+
+OcclusionTracker::OcclusionTracker(AbstractWindowSource *src, QObject *parent)
+    : QObject(parent)
+    , source(src)
+{
+    Q_ASSERT(source);
+    source->setParent(this);
+    connect(source, &AbstractWindowSource::windowsChanged, this, &OcclusionTracker::update);
+}
+
+void OcclusionTracker::setScreens(const QMap<QString, QRect> &screens)
+{
+    screenGeometry = screens;
+    update();
+}
+
+bool OcclusionTracker::isVisible(const QString &screen) const
+{
+    return visible.value(screen, true);
+}
+
+bool OcclusionTracker::isCovered(const QRect &screen, const QList<QRect> &windows)
+{
+    if (!screen.isValid())
+        return false;
+
+    // the dock is one of the windows, nothing else is left out.
+    QRegion uncovered(screen);
+    for (const QRect &win : windows)
+        uncovered -= win.adjusted(-kTolerance, -kTolerance, kTolerance, kTolerance);
+
+    return uncovered.isEmpty();
+}
+
+void OcclusionTracker::update()
+{
+    const QList<QRect> windows = source->windows();
+    QMap<QString, bool> vis;
+    for (auto itor = screenGeometry.begin(); itor != screenGeometry.end(); ++itor)
+        vis.insert(itor.key(), !isCovered(itor.value(), windows));
+
+    if (vis != visible) {
+        visible = vis;
+        fmDebug() << "screen visibility changed" << visible;
+        emit visibilityChanged();
+    }
+}
@@ -0,0 +1,70 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef OCCLUSIONTRACKER_H
+#define OCCLUSIONTRACKER_H
+
+#include <QObject>
+#include <QRect>
+#include <QMap>
+#include <QTimer>
+
+#include <DForeignWindow>
+
+namespace ddplugin_videowallpaper {
+
+// provides the geometries of the windows which are above the desktop.
+class AbstractWindowSource : public QObject
+{
+    Q_OBJECT
+public:
+    using QObject::QObject;
+    virtual QList<QRect> windows() const = 0;
+signals:
+    void windowsChanged();
+};
+
+// windows in current workspace got from window manager.
+class WindowSource : public AbstractWindowSource
+{
+    Q_OBJECT
+public:
+    explicit WindowSource(QObject *parent = nullptr);
+    ~WindowSource() override;
+    QList<QRect> windows() const override;
+protected slots:
+    // tracks the added windows and drops the closed ones.
+    void updateList();
+    void refresh();
+protected:
+    void track(DTK_GUI_NAMESPACE::DForeignWindow *win);
+    void clear();
+private:
+    QMap<WId, DTK_GUI_NAMESPACE::DForeignWindow *> tracked;   // in the order of ids
+    QList<QRect> geometries;
+    QTimer refreshTimer;   // coalesces the changes of windows
+};
+
+class OcclusionTracker : public QObject
+{
+    Q_OBJECT
+public:
+    // take the ownership of source.
+    explicit OcclusionTracker(AbstractWindowSource *source, QObject *parent = nullptr);
+    void setScreens(const QMap<QString, QRect> &screens);
+    bool isVisible(const QString &screen) const;
+    static bool isCovered(const QRect &screen, const QList<QRect> &windows);
+signals:
+    void visibilityChanged();
+protected slots:
+    void update();
+private:
+    AbstractWindowSource *source = nullptr;
+    QMap<QString, QRect> screenGeometry;
+    QMap<QString, bool> visible;
+};
+
+}
+
+#endif // OCCLUSIONTRACKER_H
@@ -0,0 +1,244 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "perfcounters.h"
+#include "ddplugin_videowallpaper_global.h"
+
+#include <QDBusConnection>
+#include <QDBusError>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+
+#include <unistd.h>
+
+using namespace ddplugin_videowallpaper;
+
+static constexpr char kService[] = "org.deepin.dde.desktop.VideoWallpaper";
+static constexpr char kPath[] = "/org/deepin/dde/desktop/VideoWallpaper/Perf";
+
+void TimeCounter::add(qint64 ns)
+{
+    const quint64 val = static_cast<quint64>(qMax(ns, qint64(0)));
+    count.fetchAndAddRelaxed(1);
+    total.fetchAndAddRelaxed(val);
+
+    quint64 old = max.loadAcquire();
+    while (val > old && !max.testAndSetOrdered(old, val, old)) { }
+}
+
+void TimeCounter::reset()
+{
+    count.storeRelease(0);
+    total.storeRelease(0);
+    max.storeRelease(0);
+}
+
+QVariantMap TimeCounter::toMap() const
+{
+    const quint64 n = count.loadAcquire();
+    const quint64 sum = total.loadAcquire();
+    QVariantMap ret;
+    ret.insert("count", n);
+    ret.insert("avgUs", n > 0 ? sum / n / 1000.0 : 0.0);
+    ret.insert("maxUs", max.loadAcquire() / 1000.0);
+    return ret;
+}
+
+void StageCounters::reset()
+{
+    decoded.storeRelease(0);
+    presented.storeRelease(0);
+    dropped.storeRelease(0);
+    late.storeRelease(0);
+    allocatedBytes.storeRelease(0);
+    present.reset();
+    scale.reset();
+    paint.reset();
+}
+
+QVariantMap StageCounters::toMap() const
+{
+    QVariantMap ret;
+    ret.insert("decoded", decoded.loadAcquire());
+    ret.insert("presented", presented.loadAcquire());
+    ret.insert("dropped", dropped.loadAcquire());
+    ret.insert("late", late.loadAcquire());
+
+    const quint64 frames = qMax(decoded.loadAcquire(), presented.loadAcquire());
+    ret.insert("allocatedBytes", allocatedBytes.loadAcquire());
+    ret.insert("allocatedBytesPerFrame", frames > 0 ? allocatedBytes.loadAcquire() / frames : 0);
+    ret.insert("present", present.toMap());
+    ret.insert("scale", scale.toMap());
+    ret.insert("paint", paint.toMap());
+    return ret;
+}
+
+class PerfCountersGlobal : public PerfCounters {};
+Q_GLOBAL_STATIC(PerfCountersGlobal, perfCounters)
+
+PerfCounters *PerfCounters::instance()
+{
+    return perfCounters;
+}
+
+PerfCounters::PerfCounters()
+{
+
+}
+
+PerfCounters::~PerfCounters()
+{
+    qDeleteAll(stages);
+    stages.clear();
+}
+
+StageCounters *PerfCounters::stage(const QString &name)
+{
+    QMutexLocker lk(&mtx);
+    StageCounters *ret = stages.value(name);
+    if (!ret) {
+        ret = new StageCounters;
+        stages.insert(name, ret);
+    }
+    return ret;
+}
+
+void PerfCounters::setSource(const QString &name, Source fn)
+{
+    QMutexLocker lk(&mtx);
+    sources.insert(name, fn);
+}
+
+void PerfCounters::removeSource(const QString &name)
+{
+    QMutexLocker lk(&mtx);
+    sources.remove(name);
+}
+
+QVariantMap PerfCounters::snapshot() const
+{
+    QMap<QString, Source> fns;
+    QVariantMap ret;
+    {
+        QMutexLocker lk(&mtx);
+        QVariantMap stageMap;
+        for (auto itor = stages.begin(); itor != stages.end(); ++itor)
+            stageMap.insert(itor.key(), itor.value()->toMap());
+        ret.insert("stages", stageMap);
+        ret.insert("startup", marks);
+        fns = sources;
+    }
+
+    // call the sources without lock, they may update counters.
+    for (auto itor = fns.begin(); itor != fns.end(); ++itor)
+        ret.insert(itor.key(), itor.value()());
+    return ret;
+}
+
+void PerfCounters::dump() const
+{
+    const QVariantMap map = snapshot();
+    for (auto itor = map.begin(); itor != map.end(); ++itor) {
+        const QJsonObject obj = QJsonObject::fromVariantMap(itor.value().toMap());
+        fmInfo() << "perf" << itor.key() << QJsonDocument(obj).toJson(QJsonDocument::Compact).constData();
+    }
+}
+
+void PerfCounters::reset()
+{
+    QMutexLocker lk(&mtx);
+    for (StageCounters *counters : stages.values())
+        counters->reset();
+}
+
+void PerfCounters::mark(const QString &name)
+{
+    const qint64 ms = sinceProcessStart();
+    {
+        QMutexLocker lk(&mtx);
+        if (marks.contains(name))
+            return;
+        marks.insert(name, ms);
+    }
+    fmInfo() << "startup mark" << name << ms << "ms";
+}
+
+qint64 PerfCounters::residentBytes()
+{
+    // the second field is the resident pages.
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QFile::ReadOnly))
+        return 0;
+
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.size() > 1 ? fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE) : 0;
+}
+
+qint64 PerfCounters::sinceProcessStart()
+{
+    // the start time is in clock ticks since boot, the 22nd field of stat.
+    QFile stat("/proc/self/stat");
+    QFile uptime("/proc/uptime");
+    if (stat.open(QFile::ReadOnly) && uptime.open(QFile::ReadOnly)) {
+        const QByteArray line = stat.readAll();
+        // the name of process in brackets may contain spaces.
+        const QList<QByteArray> fields = line.mid(line.lastIndexOf(')') + 2).split(' ');
+        const long ticks = sysconf(_SC_CLK_TCK);
+        const double now = uptime.readAll().split(' ').first().toDouble();
+        if (fields.size() > 19 && ticks > 0)
+            return qRound64(now * 1000 - fields.at(19).toDouble() * 1000 / ticks);
+    }
+
+    // since the first call.
+    static QElapsedTimer timer;
+    if (!timer.isValid())
+        timer.start();
+    return timer.elapsed();
+}
+
+PerfCountersDBus::PerfCountersDBus(QObject *parent) : QObject(parent)
+{
+
+}
+
+PerfCountersDBus::~PerfCountersDBus()
+{
+    if (registered) {
+        QDBusConnection::sessionBus().unregisterObject(kPath);
+        QDBusConnection::sessionBus().unregisterService(kService);
+    }
+}
+
+bool PerfCountersDBus::registerOn()
+{
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    if (!bus.registerObject(kPath, this, QDBusConnection::ExportScriptableSlots)) {
+        fmWarning() << "can not register perf counters on" << kPath << bus.lastError().message();
+        return false;
+    }
+
+    if (!bus.registerService(kService))
+        fmWarning() << "can not register service" << kService << bus.lastError().message();
+
+    registered = true;
+    return true;
+}
+
+QVariantMap PerfCountersDBus::Counters() const
+{
+    return PerfCounters::instance()->snapshot();
+}
+
+void PerfCountersDBus::Dump() const
+{
+    PerfCounters::instance()->dump();
+}
+
+void PerfCountersDBus::Reset()
+{
+    PerfCounters::instance()->reset();
+}
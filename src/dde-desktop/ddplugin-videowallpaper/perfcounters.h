@@ -0,0 +1,91 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <QObject>
+#include <QAtomicInteger>
+#include <QMutex>
+#include <QMap>
+#include <QVariantMap>
+
+#include <functional>
+
+namespace ddplugin_videowallpaper {
+
+class TimeCounter
+{
+public:
+    void add(qint64 ns);
+    void reset();
+    QVariantMap toMap() const;
+private:
+    QAtomicInteger<quint64> count;
+    QAtomicInteger<quint64> total;   // ns
+    QAtomicInteger<quint64> max;
+};
+
+// the counters of one stage, they are lock free and can be updated in any thread.
+struct StageCounters
+{
+    QAtomicInteger<quint64> decoded;
+    QAtomicInteger<quint64> presented;
+    QAtomicInteger<quint64> dropped;
+    QAtomicInteger<quint64> late;
+    QAtomicInteger<quint64> allocatedBytes;
+    TimeCounter present;
+    TimeCounter scale;
+    TimeCounter paint;
+    void reset();
+    QVariantMap toMap() const;
+};
+
+class PerfCounters
+{
+public:
+    typedef std::function<QVariantMap()> Source;
+    static PerfCounters *instance();
+    // the counters of screen, or of decoder. the pointer is valid until exit.
+    StageCounters *stage(const QString &name);
+    // the values like hwdec status sampled when reading.
+    void setSource(const QString &name, Source fn);
+    void removeSource(const QString &name);
+    QVariantMap snapshot() const;
+    void dump() const;
+    void reset();
+    // records the ms since the process started, only the first mark of a name is kept.
+    void mark(const QString &name);
+    static qint64 sinceProcessStart();
+    static qint64 residentBytes();
+protected:
+    PerfCounters();
+    ~PerfCounters();
+private:
+    mutable QMutex mtx;
+    QMap<QString, StageCounters *> stages;
+    QMap<QString, Source> sources;
+    QVariantMap marks;
+};
+
+// exports the counters on session bus.
+class PerfCountersDBus : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.deepin.dde.desktop.VideoWallpaper.Perf")
+public:
+    explicit PerfCountersDBus(QObject *parent = nullptr);
+    ~PerfCountersDBus() override;
+    bool registerOn();
+public slots:
+    Q_SCRIPTABLE QVariantMap Counters() const;
+    Q_SCRIPTABLE void Dump() const;
+    Q_SCRIPTABLE void Reset();
+private:
+    bool registered = false;
+};
+
+}
+
+#endif // PERFCOUNTERS_H
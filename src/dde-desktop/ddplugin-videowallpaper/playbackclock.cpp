@@ -0,0 +1,138 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifdef USE_LIBDMR
+
+#include "playbackclock.h"
+#include "ddplugin_videowallpaper_global.h"
+
+using namespace ddplugin_videowallpaper;
+
+static constexpr int kTickInterval = 500;   // ms
+// the drift larger than it is fixed by seeking, the smaller by speed.
+static constexpr int kSeekThreshold = 500;   // ms
+// the time to catch up the drift by speed.
+static constexpr int kCorrectTime = 2000;   // ms
+static constexpr qreal kMaxSpeedOffset = 0.1;
+
+PlaybackClock::PlaybackClock(QObject *parent) : QObject(parent)
+{
+    timer.setInterval(kTickInterval);
+    connect(&timer, &QTimer::timeout, this, &PlaybackClock::tick);
+}
+
+void PlaybackClock::setGroups(const QList<QList<VideoProxy *>> &list)
+{
+    for (const Group &group : groups) {
+        for (const QPointer<VideoProxy> &dec : group) {
+            if (!dec)
+                continue;
+            disconnect(dec.data(), &VideoProxy::itemChanged, this, &PlaybackClock::followItem);
+            dec->setSpeed(1.0);
+        }
+    }
+    groups.clear();
+
+    for (const QList<VideoProxy *> &decs : list) {
+        // a single decoder has nothing to follow.
+        if (decs.size() < 2)
+            continue;
+
+        // the first one reaching the end of item switches all of them.
+        Group group;
+        for (VideoProxy *dec : decs) {
+            group.append(dec);
+            connect(dec, &VideoProxy::itemChanged, this, &PlaybackClock::followItem);
+        }
+        groups.append(group);
+    }
+
+    if (groups.isEmpty())
+        timer.stop();
+    else
+        timer.start();
+}
+
+QVariantMap PlaybackClock::stats() const
+{
+    QVariantMap ret;
+    ret.insert("groups", groups.size());
+    ret.insert("driftMs", lastDrift);
+    ret.insert("maxDriftMs", maxDrift);
+    ret.insert("corrections", corrections);
+    ret.insert("seeks", seeks);
+    ret.insert("switches", switches);
+    return ret;
+}
+
+void PlaybackClock::tick()
+{
+    lastDrift = 0;
+    for (const Group &group : groups) {
+        // the first playing one leads, the paused ones are caught up after resuming.
+        VideoProxy *leader = nullptr;
+        qint64 pos = -1;
+        for (const QPointer<VideoProxy> &dec : group) {
+            pos = dec ? dec->position() : -1;
+            if (pos >= 0) {
+                leader = dec.data();
+                break;
+            }
+        }
+
+        if (!leader)
+            continue;
+
+        const int index = leader->currentIndex();
+        const qreal interval = leader->frameInterval();
+        for (const QPointer<VideoProxy> &ptr : group) {
+            VideoProxy *dec = ptr.data();
+            if (!dec || dec == leader)
+                continue;
+
+            if (dec->currentIndex() != index) {
+                switches++;
+                dec->playIndex(index);
+                continue;
+            }
+
+            const qint64 p = dec->position();
+            if (p < 0)
+                continue;
+
+            const qint64 drift = p - pos;
+            lastDrift = qMax(lastDrift, qAbs(drift));
+            maxDrift = qMax(maxDrift, lastDrift);
+            if (qAbs(drift) > kSeekThreshold) {
+                seeks++;
+                dec->seekTo(pos);
+                dec->setSpeed(1.0);
+            } else if (qAbs(drift) > interval) {
+                corrections++;
+                const qreal offset = qBound(-kMaxSpeedOffset, -qreal(drift) / kCorrectTime, kMaxSpeedOffset);
+                dec->setSpeed(1.0 + offset);
+            } else {
+                dec->setSpeed(1.0);
+            }
+        }
+    }
+}
+
+void PlaybackClock::followItem(int index)
+{
+    VideoProxy *from = qobject_cast<VideoProxy *>(sender());
+    for (const Group &group : groups) {
+        if (!group.contains(from))
+            continue;
+
+        for (const QPointer<VideoProxy> &dec : group) {
+            if (dec && dec != from && dec->currentIndex() != index) {
+                switches++;
+                dec->playIndex(index);
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,42 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef PLAYBACKCLOCK_H
+#define PLAYBACKCLOCK_H
+
+#ifdef USE_LIBDMR
+#include "videoproxy.h"
+
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+namespace ddplugin_videowallpaper {
+
+// keeps the decoders playing the same list in step, the first playing one of a group leads.
+// the screens sharing a decoder are in step already, so only decoders are scheduled.
+class PlaybackClock : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PlaybackClock(QObject *parent = nullptr);
+    void setGroups(const QList<QList<VideoProxy *>> &groups);
+    QVariantMap stats() const;
+protected slots:
+    void tick();
+    void followItem(int index);
+private:
+    typedef QList<QPointer<VideoProxy>> Group;
+    QList<Group> groups;
+    QTimer timer;   // one timer for all groups
+    qint64 lastDrift = 0;   // ms, the largest one in last tick
+    qint64 maxDrift = 0;
+    quint64 corrections = 0;
+    quint64 seeks = 0;
+    quint64 switches = 0;
+};
+
+}
+#endif
+#endif // PLAYBACKCLOCK_H
@@ -0,0 +1,179 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "powerpolicy.h"
+#include "ddplugin_videowallpaper_global.h"
+
+#include <QDir>
+#include <QFile>
+
+using namespace ddplugin_videowallpaper;
+
+static QString readValue(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly))
+        return QString();
+    return QString::fromLatin1(file.readAll()).trimmed();
+}
+
+SysfsPowerProvider::SysfsPowerProvider(const QString &root, QObject *parent)
+    : AbstractPowerProvider(parent)
+    , sysfs(root)
+{
+    pollTimer.setInterval(5000);
+    connect(&pollTimer, &QTimer::timeout, this, &SysfsPowerProvider::refresh);
+    pollTimer.start();
+    refresh();
+}
+
+PowerState SysfsPowerProvider::state() const
+{
+    return current;
+}
+
+void SysfsPowerProvider::refresh()
+{
+    PowerState st;
+    bool externalOnline = false;
+    bool discharging = false;
+    bool hasBattery = false;
+    int battery = 100;
+
+    QDir supply(sysfs + "/class/power_supply");
+    for (const QString &name : supply.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        const QString dev = supply.absoluteFilePath(name);
+        // skip the batteries of peripherals such as mouse and keyboard.
+        if (readValue(dev + "/scope") == "Device")
+            continue;
+
+        const QString type = readValue(dev + "/type");
+        if (type == "Battery") {
+            bool ok = false;
+            int cap = readValue(dev + "/capacity").toInt(&ok);
+            if (ok) {
+                battery = hasBattery ? qMin(battery, cap) : cap;
+                hasBattery = true;
+            }
+            discharging = discharging || readValue(dev + "/status") == "Discharging";
+        } else {
+            // Mains, USB, USB_C, USB_PD and so on.
+            externalOnline = externalOnline || readValue(dev + "/online") == "1";
+        }
+    }
+
+    // some chargers, e.g. USB-C only laptops, are not reported as Mains,
+    // so it is on battery only if the battery is discharging without any supply.
+    st.onBattery = hasBattery && discharging && !externalOnline;
+    st.battery = battery;
+    st.powerSaver = readValue(sysfs + "/firmware/acpi/platform_profile") == "low-power";
+
+    QDir thermal(sysfs + "/class/thermal");
+    for (const QString &name : thermal.entryList({ "thermal_zone*" }, QDir::Dirs | QDir::NoDotAndDotDot)) {
+        bool ok = false;
+        int temp = readValue(thermal.absoluteFilePath(name) + "/temp").toInt(&ok);
+        if (ok)
+            st.temperature = qMax(st.temperature, temp / 1000);
+    }
+
+    if (st.onBattery != current.onBattery || st.battery != current.battery
+            || st.powerSaver != current.powerSaver || st.temperature != current.temperature) {
+        current = st;
+        emit stateChanged();
+    }
+}
+
+PowerPolicy::PowerPolicy(AbstractPowerProvider *pro, const PowerThresholds &thresholds, QObject *parent)
+    : QObject(parent)
+    , provider(pro)
+    , thr(thresholds)
+{
+    Q_ASSERT(provider);
+    provider->setParent(this);
+    connect(provider, &AbstractPowerProvider::stateChanged, this, &PowerPolicy::update);
+
+    // check again when the relaxing state lasts long enough.
+    holdTimer.setSingleShot(true);
+    connect(&holdTimer, &QTimer::timeout, this, &PowerPolicy::update);
+    update();
+}
+
+PowerPolicy::Level PowerPolicy::level() const
+{
+    return current;
+}
+
+void PowerPolicy::setThresholds(const PowerThresholds &thresholds)
+{
+    thr = thresholds;
+    update();
+}
+
+PowerPolicy::Level PowerPolicy::evaluate(const PowerState &state, const PowerThresholds &thr, bool relax)
+{
+    if (!thr.enable)
+        return kNormal;
+
+    // going back to a lower level needs a margin against the thresholds.
+    const int battery = state.battery - (relax ? thr.batteryMargin : 0);
+    const int temperature = state.temperature + (relax ? thr.thermalMargin : 0);
+
+    int lv = kNormal;
+    if (state.onBattery) {
+        lv = kReducedFps;
+        if (battery <= thr.batteryLow)
+            lv = kReducedResolution;
+        if (battery <= thr.batteryCritical)
+            lv = kPoster;
+    }
+
+    if (state.powerSaver)
+        lv = qMin(lv + 1, static_cast<int>(kPoster));
+
+    if (temperature >= thr.thermalCritical)
+        lv = qMax(lv, static_cast<int>(kPaused));
+    else if (temperature >= thr.thermalHot)
+        lv = qMax(lv, static_cast<int>(kReducedResolution));
+    else if (temperature >= thr.thermalWarm)
+        lv = qMax(lv, static_cast<int>(kReducedFps));
+
+    return static_cast<Level>(lv);
+}
+
+void PowerPolicy::update()
+{
+    const PowerState st = provider->state();
+    Level target = evaluate(st, thr);
+
+    if (target > current) {
+        // step up at once.
+        relaxing.invalidate();
+        holdTimer.stop();
+    } else if (target < current) {
+        // step down only if the state keeps being good enough for a while.
+        target = qMax(evaluate(st, thr, true), target);
+        if (target < current) {
+            if (!relaxing.isValid())
+                relaxing.start();
+
+            const qint64 remain = thr.holdTime * 1000 - relaxing.elapsed();
+            if (remain > 0) {
+                holdTimer.start(static_cast<int>(remain));
+                return;
+            }
+        }
+        relaxing.invalidate();
+        holdTimer.stop();
+    } else {
+        relaxing.invalidate();
+        holdTimer.stop();
+    }
+
+    if (target != current) {
+        fmInfo() << "power policy changed from" << current << "to" << target << "on battery" << st.onBattery
+                 << "battery" << st.battery << "power saver" << st.powerSaver << "temperature" << st.temperature;
+        current = target;
+        emit levelChanged(current);
+    }
+}
@@ -0,0 +1,82 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef POWERPOLICY_H
+#define POWERPOLICY_H
+
+#include "wallpaperconfig.h"
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+namespace ddplugin_videowallpaper {
+
+struct PowerState
+{
+    bool onBattery = false;
+    int battery = 100;   // percent
+    bool powerSaver = false;
+    int temperature = 0;   // the hottest thermal zone in celsius
+};
+
+class AbstractPowerProvider : public QObject
+{
+    Q_OBJECT
+public:
+    using QObject::QObject;
+    virtual PowerState state() const = 0;
+signals:
+    void stateChanged();
+};
+
+// reads power supply, platform profile and thermal zones from sysfs.
+class SysfsPowerProvider : public AbstractPowerProvider
+{
+    Q_OBJECT
+public:
+    explicit SysfsPowerProvider(const QString &root = "/sys", QObject *parent = nullptr);
+    PowerState state() const override;
+protected slots:
+    void refresh();
+private:
+    QString sysfs;
+    PowerState current;
+    QTimer pollTimer;
+};
+
+class PowerPolicy : public QObject
+{
+    Q_OBJECT
+public:
+    enum Level {
+        kNormal = 0,
+        kReducedFps,
+        kReducedResolution,
+        kPoster,   // paused with the last frame
+        kPaused   // paused and the background is shown
+    };
+    Q_ENUM(Level)
+
+    // take the ownership of provider.
+    explicit PowerPolicy(AbstractPowerProvider *provider, const PowerThresholds &thresholds,
+                         QObject *parent = nullptr);
+    Level level() const;
+    void setThresholds(const PowerThresholds &thresholds);
+    static Level evaluate(const PowerState &state, const PowerThresholds &thresholds, bool relax = false);
+signals:
+    void levelChanged(Level level);
+public slots:
+    void update();
+private:
+    AbstractPowerProvider *provider = nullptr;
+    PowerThresholds thr;
+    Level current = kNormal;
+    QElapsedTimer relaxing;
+    QTimer holdTimer;
+};
+
+}
+
+#endif // POWERPOLICY_H
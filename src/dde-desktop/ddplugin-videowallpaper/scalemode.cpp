@@ -0,0 +1,58 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "scalemode.h"
+
+using namespace ddplugin_videowallpaper;
+
+static QRect centerIn(const QSize &size, const QSize &outer)
+{
+    return QRect(QPoint((outer.width() - size.width()) / 2, (outer.height() - size.height()) / 2), size);
+}
+
+ScaleGeometry ScaleGeometry::compute(const QSize &source, const QSize &target, ScaleMode mode)
+{
+    ScaleGeometry ret;
+    ret.source = QRect(QPoint(0, 0), source);
+    ret.target = target;
+    if (source.isEmpty() || target.isEmpty())
+        return ret;
+
+    switch (mode) {
+    case kScaleFill:
+        // the largest region of source having the aspect ratio of target.
+        ret.source = centerIn(target.scaled(source, Qt::KeepAspectRatio), source);
+        break;
+    case kScaleStretch:
+        break;
+    case kScaleCenter: {
+        const QSize visible = source.boundedTo(target);
+        ret.source = centerIn(visible, source);
+        ret.target = visible;
+        break;
+    }
+    default:
+        ret.target = source.scaled(target, Qt::KeepAspectRatio);
+        break;
+    }
+
+    return ret;
+}
+
+ScaleMode ScaleGeometry::modeFromString(const QString &mode)
+{
+    if (mode == "fill")
+        return kScaleFill;
+    if (mode == "stretch")
+        return kScaleStretch;
+    if (mode == "center")
+        return kScaleCenter;
+    return kScaleFit;
+}
+
+ScaleMode ScaleGeometry::spanMode(ScaleMode mode)
+{
+    // the bars of fit and center would lie across the screens.
+    return mode == kScaleStretch ? kScaleStretch : kScaleFill;
+}
@@ -0,0 +1,33 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SCALEMODE_H
+#define SCALEMODE_H
+
+#include <QRect>
+#include <QString>
+
+namespace ddplugin_videowallpaper {
+
+enum ScaleMode {
+    kScaleFit,   // keep aspect ratio with bars
+    kScaleFill,   // keep aspect ratio and crop to cover
+    kScaleStretch,
+    kScaleCenter   // no scaling
+};
+
+struct ScaleGeometry
+{
+    QRect source;   // the visible region of source
+    QSize target;   // the size it is scaled to
+    // both sizes are in pixels.
+    static ScaleGeometry compute(const QSize &source, const QSize &target, ScaleMode mode);
+    static ScaleMode modeFromString(const QString &mode);
+    // the video covers the canvas spanning all screens, it is cropped unless stretched.
+    static ScaleMode spanMode(ScaleMode mode);
+};
+
+}
+
+#endif // SCALEMODE_H
@@ -0,0 +1,175 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "sessionmonitor.h"
+#include "ddplugin_videowallpaper_global.h"
+
+#include <QDBusMessage>
+#include <QDBusObjectPath>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QDBusVariant>
+#include <QDir>
+#include <QFile>
+
+#include <unistd.h>
+
+using namespace ddplugin_videowallpaper;
+
+DBusSessionSource::DBusSessionSource(QObject *parent)
+    : DBusSessionSource(QDBusConnection::systemBus(), QDBusConnection::sessionBus(), Names(), parent)
+{
+
+}
+
+DBusSessionSource::DBusSessionSource(const QDBusConnection &system, const QDBusConnection &session,
+                                     const Names &n, QObject *parent)
+    : AbstractSessionSource(parent)
+    , systemBus(system)
+    , sessionBus(session)
+    , names(n)
+{
+    // the monitors are turned off after the session gets idle, check them only then.
+    blankTimer.setInterval(3000);
+    connect(&blankTimer, &QTimer::timeout, this, &DBusSessionSource::checkBlank);
+    connectBus();
+}
+
+void DBusSessionSource::connectBus()
+{
+    systemBus.connect(names.login, "/org/freedesktop/login1", "org.freedesktop.login1.Manager",
+                      "PrepareForSleep", this, SLOT(onPrepareForSleep(bool)));
+
+    // only the session of this process, the signals of other sessions are ignored.
+    connectSession("GetSessionByPID", static_cast<uint>(getpid()));
+
+    // dde-lock does not always let logind emit Unlock, follow the lock state of deepin session too.
+    sessionBus.connect(names.sessionManager, names.sessionManagerPath, "org.freedesktop.DBus.Properties",
+                       "PropertiesChanged", this,
+                       SLOT(onSessionPropertiesChanged(QString, QVariantMap, QStringList)));
+    {
+        auto msg = QDBusMessage::createMethodCall(names.sessionManager, names.sessionManagerPath,
+                                                  "org.freedesktop.DBus.Properties", "Get");
+        msg << names.sessionManager << QString("Locked");
+        auto watcher = new QDBusPendingCallWatcher(sessionBus.asyncCall(msg), this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *call) {
+            call->deleteLater();
+            QDBusPendingReply<QDBusVariant> reply = *call;
+            if (!reply.isError())
+                setLocked(reply.value().variant().toBool());
+        });
+    }
+
+    sessionBus.connect(names.screenSaver, names.screenSaverPath, "org.freedesktop.ScreenSaver",
+                       "ActiveChanged", this, SLOT(onScreenSaverActive(bool)));
+}
+
+void DBusSessionSource::onPrepareForSleep(bool sleep)
+{
+    fmInfo() << "system" << (sleep ? "is going to sleep" : "resumed");
+    emit sleepChanged(sleep);
+}
+
+void DBusSessionSource::connectSession(const QString &method, const QVariant &arg)
+{
+    auto msg = QDBusMessage::createMethodCall(names.login, "/org/freedesktop/login1",
+                                              "org.freedesktop.login1.Manager", method);
+    msg << arg;
+    auto watcher = new QDBusPendingCallWatcher(systemBus.asyncCall(msg), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, method](QDBusPendingCallWatcher *call) {
+        call->deleteLater();
+        QDBusPendingReply<QDBusObjectPath> reply = *call;
+        if (reply.isError()) {
+            // the process may be out of any session, use the session of the caller then.
+            if (method == "GetSessionByPID") {
+                connectSession("GetSession", QString("auto"));
+            } else {
+                fmWarning() << "can not get the login session" << reply.error().message();
+            }
+            return;
+        }
+
+        sessionPath = reply.value().path();
+        fmInfo() << "login session" << sessionPath;
+        systemBus.connect(names.login, sessionPath, "org.freedesktop.login1.Session",
+                          "Lock", this, SLOT(onLock()));
+        systemBus.connect(names.login, sessionPath, "org.freedesktop.login1.Session",
+                          "Unlock", this, SLOT(onUnlock()));
+    });
+}
+
+void DBusSessionSource::onLock()
+{
+    setLocked(true);
+}
+
+void DBusSessionSource::onUnlock()
+{
+    setLocked(false);
+}
+
+void DBusSessionSource::onSessionPropertiesChanged(const QString &interface, const QVariantMap &changed,
+                                                   const QStringList &invalidated)
+{
+    Q_UNUSED(invalidated)
+    if (interface != names.sessionManager || !changed.contains("Locked"))
+        return;
+
+    setLocked(changed.value("Locked").toBool());
+}
+
+void DBusSessionSource::setLocked(bool lock)
+{
+    // both logind and deepin session may report the same change.
+    if (lock == locked)
+        return;
+
+    locked = lock;
+    fmInfo() << (locked ? "session locked" : "session unlocked");
+    emit lockChanged(locked);
+}
+
+void DBusSessionSource::onScreenSaverActive(bool active)
+{
+    fmInfo() << "session idle" << active;
+    emit idleChanged(active);
+
+    if (active) {
+        blankTimer.start();
+        checkBlank();
+    } else {
+        blankTimer.stop();
+        if (blanked) {
+            blanked = false;
+            emit blankChanged(false);
+        }
+    }
+}
+
+void DBusSessionSource::checkBlank()
+{
+    // blanked if all connected monitors are off.
+    bool on = false;
+    bool connected = false;
+    QDir drm(names.drm);
+    for (const QString &name : drm.entryList({ "card*-*" }, QDir::Dirs | QDir::NoDotAndDotDot)) {
+        QFile status(drm.absoluteFilePath(name) + "/status");
+        if (!status.open(QFile::ReadOnly) || status.readAll().trimmed() != "connected")
+            continue;
+
+        connected = true;
+        QFile dpms(drm.absoluteFilePath(name) + "/dpms");
+        if (dpms.open(QFile::ReadOnly) && dpms.readAll().trimmed() == "On") {
+            on = true;
+            break;
+        }
+    }
+
+    const bool blank = connected && !on;
+    if (blank != blanked) {
+        blanked = blank;
+        fmInfo() << "monitors blanked" << blanked;
+        emit blankChanged(blanked);
+    }
+}
@@ -0,0 +1,70 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SESSIONMONITOR_H
+#define SESSIONMONITOR_H
+
+#include <QObject>
+#include <QDBusConnection>
+#include <QTimer>
+#include <QVariant>
+
+namespace ddplugin_videowallpaper {
+
+// events of session lock, idle, monitor power and system sleep.
+class AbstractSessionSource : public QObject
+{
+    Q_OBJECT
+public:
+    using QObject::QObject;
+signals:
+    void lockChanged(bool locked);
+    void idleChanged(bool idle);
+    void blankChanged(bool blanked);
+    void sleepChanged(bool sleeping);   // false after resuming
+};
+
+class DBusSessionSource : public AbstractSessionSource
+{
+    Q_OBJECT
+public:
+    // the services can be replaced by local stand-ins.
+    struct Names
+    {
+        QString login = "org.freedesktop.login1";
+        QString screenSaver = "org.freedesktop.ScreenSaver";
+        QString screenSaverPath = "/org/freedesktop/ScreenSaver";
+        QString sessionManager = "com.deepin.SessionManager";
+        QString sessionManagerPath = "/com/deepin/SessionManager";
+        QString drm = "/sys/class/drm";   // dpms state of connectors
+    };
+
+    explicit DBusSessionSource(QObject *parent = nullptr);
+    DBusSessionSource(const QDBusConnection &system, const QDBusConnection &session,
+                      const Names &names, QObject *parent = nullptr);
+protected slots:
+    void onPrepareForSleep(bool sleep);
+    void onLock();
+    void onUnlock();
+    void onSessionPropertiesChanged(const QString &interface, const QVariantMap &changed,
+                                    const QStringList &invalidated);
+    void onScreenSaverActive(bool active);
+    void checkBlank();
+protected:
+    void connectBus();
+    void connectSession(const QString &method, const QVariant &arg);
+    void setLocked(bool lock);
+private:
+    QDBusConnection systemBus;
+    QDBusConnection sessionBus;
+    Names names;
+    QTimer blankTimer;
+    QString sessionPath;   // object path of our logind session
+    bool locked = false;
+    bool blanked = false;
+};
+
+}
+
+#endif // SESSIONMONITOR_H
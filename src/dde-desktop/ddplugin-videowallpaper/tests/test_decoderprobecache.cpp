@@ -0,0 +1,132 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "decoderprobecache.h"
+#include "ddplugin_videowallpaper_global.h"
+
+#include <QTemporaryDir>
+#include <QtTest>
+
+namespace ddplugin_videowallpaper {
+DFM_LOG_REISGER_CATEGORY(DDP_VIDEOWALLPAPER_NAMESPACE)
+}
+
+using namespace ddplugin_videowallpaper;
+
+// the streams and driver of a machine without GPU.
+class MockProbeBackend : public DecoderProbeBackend
+{
+public:
+    explicit MockProbeBackend(const QString &drv = "mock-driver")
+        : driver(drv)
+    {
+    }
+    QString driverFingerprint() override
+    {
+        return driver;
+    }
+    DecodeKey streamOf(const QString &file) override
+    {
+        return streams.value(file);
+    }
+    QString driver;
+    QHash<QString, DecodeKey> streams;
+};
+
+static MockProbeBackend *newBackend(const QString &driver = "mock-driver")
+{
+    auto backend = new MockProbeBackend(driver);
+    backend->streams.insert("/a.mp4", DecodeKey { "hevc", "Main 10", QSize(3840, 2160) });
+    backend->streams.insert("/b.mp4", DecodeKey { "hevc", "Main 10", QSize(3840, 2160) });
+    backend->streams.insert("/c.mp4", DecodeKey { "h264", "High", QSize(1920, 1080) });
+    return backend;
+}
+
+static DecodePath makePath(const QString &hwdec, qint64 startup)
+{
+    DecodePath dp;
+    dp.hwdec = hwdec;
+    dp.startup = startup;
+    return dp;
+}
+
+class TestDecoderProbeCache : public QObject
+{
+    Q_OBJECT
+private slots:
+    void init()
+    {
+        QVERIFY(dir.isValid());
+        file = dir.filePath(QString("decoders-%0.json").arg(++count));
+    }
+
+    void unknownStream()
+    {
+        DecoderProbeCache cache(newBackend(), file);
+        QVERIFY(!cache.lookup("/a.mp4").isValid());
+        // not in the mock, the stream is unknown.
+        QVERIFY(!cache.lookup("/unknown.mp4").isValid());
+        QVERIFY(!cache.record("/unknown.mp4", makePath("vaapi", 100)));
+        QVERIFY(!cache.lookup("/unknown.mp4").isValid());
+    }
+
+    void sharedByStream()
+    {
+        DecoderProbeCache cache(newBackend(), file);
+        QVERIFY(cache.record("/a.mp4", makePath("no", 800)));
+
+        // the same kind of stream uses the recorded path.
+        const DecodePath dp = cache.lookup("/b.mp4");
+        QCOMPARE(dp.hwdec, QString("no"));
+        QCOMPARE(dp.startup, qint64(800));
+        QVERIFY(!cache.lookup("/c.mp4").isValid());
+    }
+
+    void recordChanges()
+    {
+        DecoderProbeCache cache(newBackend(), file);
+        QVERIFY(cache.record("/c.mp4", makePath("vaapi", -1)));
+        // the unknown cost is filled without changing the path.
+        QVERIFY(!cache.record("/c.mp4", makePath("vaapi", 120)));
+        QCOMPARE(cache.lookup("/c.mp4").startup, qint64(120));
+        // the first cost is kept.
+        QVERIFY(!cache.record("/c.mp4", makePath("vaapi", 300)));
+        QCOMPARE(cache.lookup("/c.mp4").startup, qint64(120));
+        // falling back to software.
+        QVERIFY(cache.record("/c.mp4", makePath("no", -1)));
+        QCOMPARE(cache.lookup("/c.mp4").hwdec, QString("no"));
+        QCOMPARE(cache.lookup("/c.mp4").startup, qint64(120));
+    }
+
+    void persisted()
+    {
+        {
+            DecoderProbeCache cache(newBackend(), file);
+            QVERIFY(cache.record("/a.mp4", makePath("vdpau", 200)));
+        }
+
+        DecoderProbeCache cache(newBackend(), file);
+        QCOMPARE(cache.lookup("/b.mp4").hwdec, QString("vdpau"));
+    }
+
+    void driverChanged()
+    {
+        {
+            DecoderProbeCache cache(newBackend(), file);
+            QVERIFY(cache.record("/a.mp4", makePath("vdpau", 200)));
+        }
+
+        DecoderProbeCache cache(newBackend("other-driver"), file);
+        QVERIFY(!cache.lookup("/a.mp4").isValid());
+    }
+
+private:
+    QTemporaryDir dir;
+    QString file;
+    int count = 0;
+};
+
+QTEST_GUILESS_MAIN(TestDecoderProbeCache)
+
+#include "test_decoderprobecache.moc"
@@ -0,0 +1,93 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "occlusiontracker.h"
+#include "ddplugin_videowallpaper_global.h"
+
+#include <QSignalSpy>
+#include <QtTest>
+
+namespace ddplugin_videowallpaper {
+DFM_LOG_REISGER_CATEGORY(DDP_VIDEOWALLPAPER_NAMESPACE)
+}
+
+using namespace ddplugin_videowallpaper;
+
+class FakeWindowSource : public AbstractWindowSource
+{
+public:
+    using AbstractWindowSource::AbstractWindowSource;
+    QList<QRect> windows() const override
+    {
+        return rects;
+    }
+    void setWindows(const QList<QRect> &wins)
+    {
+        rects = wins;
+        emit windowsChanged();
+    }
+private:
+    QList<QRect> rects;
+};
+
+class TestOcclusionTracker : public QObject
+{
+    Q_OBJECT
+private slots:
+    void isCovered_data()
+    {
+        QTest::addColumn<QList<QRect>>("windows");
+        QTest::addColumn<bool>("covered");
+
+        QTest::newRow("no window") << QList<QRect>() << false;
+        QTest::newRow("small window") << QList<QRect> { QRect(100, 100, 400, 300) } << false;
+        QTest::newRow("maximized with dock") << QList<QRect> { QRect(0, 0, 1920, 1030), QRect(0, 1030, 1920, 50) } << true;
+        QTest::newRow("maximized without dock") << QList<QRect> { QRect(0, 0, 1920, 1030) } << false;
+        QTest::newRow("partly covered") << QList<QRect> { QRect(0, 0, 1900, 1080) } << false;
+        QTest::newRow("gap of pixels") << QList<QRect> { QRect(0, 0, 959, 1080), QRect(961, 0, 959, 1080) } << true;
+        QTest::newRow("fullscreen") << QList<QRect> { QRect(0, 0, 1920, 1080) } << true;
+        QTest::newRow("two halves") << QList<QRect> { QRect(0, 0, 960, 1080), QRect(960, 0, 960, 1080) } << true;
+        QTest::newRow("other screen") << QList<QRect> { QRect(1920, 0, 1920, 1080) } << false;
+    }
+
+    void isCovered()
+    {
+        QFETCH(QList<QRect>, windows);
+        QFETCH(bool, covered);
+        QCOMPARE(OcclusionTracker::isCovered(QRect(0, 0, 1920, 1080), windows), covered);
+    }
+
+    void visibility()
+    {
+        auto source = new FakeWindowSource;
+        OcclusionTracker tracker(source);
+        tracker.setScreens({ { "HDMI-1", QRect(0, 0, 1920, 1080) }, { "DP-1", QRect(1920, 0, 1920, 1080) } });
+        QVERIFY(tracker.isVisible("HDMI-1"));
+        QVERIFY(tracker.isVisible("DP-1"));
+
+        QSignalSpy spy(&tracker, &OcclusionTracker::visibilityChanged);
+        source->setWindows({ QRect(1920, 0, 1920, 1080) });
+        QCOMPARE(spy.count(), 1);
+        QVERIFY(tracker.isVisible("HDMI-1"));
+        QVERIFY(!tracker.isVisible("DP-1"));
+
+        // nothing is emitted if the visibility is not changed.
+        source->setWindows({ QRect(1920, 0, 1920, 1080), QRect(10, 10, 100, 100) });
+        QCOMPARE(spy.count(), 1);
+
+        source->setWindows({});
+        QCOMPARE(spy.count(), 2);
+        QVERIFY(tracker.isVisible("DP-1"));
+    }
+
+    void unknownScreen()
+    {
+        OcclusionTracker tracker(new FakeWindowSource);
+        QVERIFY(tracker.isVisible("unknown"));
+    }
+};
+
+QTEST_GUILESS_MAIN(TestOcclusionTracker)
+
+#include "test_occlusiontracker.moc"
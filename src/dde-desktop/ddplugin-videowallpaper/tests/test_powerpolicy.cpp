@@ -0,0 +1,188 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "powerpolicy.h"
+#include "ddplugin_videowallpaper_global.h"
+
+#include <QSignalSpy>
+#include <QtTest>
+
+namespace ddplugin_videowallpaper {
+DFM_LOG_REISGER_CATEGORY(DDP_VIDEOWALLPAPER_NAMESPACE)
+}
+
+using namespace ddplugin_videowallpaper;
+
+Q_DECLARE_METATYPE(ddplugin_videowallpaper::PowerState)
+
+class FakePowerProvider : public AbstractPowerProvider
+{
+public:
+    using AbstractPowerProvider::AbstractPowerProvider;
+    PowerState state() const override
+    {
+        return current;
+    }
+    void setState(const PowerState &st)
+    {
+        current = st;
+        emit stateChanged();
+    }
+    PowerState current;
+};
+
+static PowerState battery(int percent, int temperature = 40)
+{
+    PowerState st;
+    st.onBattery = true;
+    st.battery = percent;
+    st.temperature = temperature;
+    return st;
+}
+
+static PowerState mains(int temperature = 40)
+{
+    PowerState st;
+    st.temperature = temperature;
+    return st;
+}
+
+// the states must last one second to step down.
+static PowerThresholds thresholds()
+{
+    PowerThresholds thr;
+    thr.holdTime = 1;
+    return thr;
+}
+
+class TestPowerPolicy : public QObject
+{
+    Q_OBJECT
+private slots:
+    void evaluate_data()
+    {
+        QTest::addColumn<PowerState>("state");
+        QTest::addColumn<int>("level");
+
+        PowerState saver = mains();
+        saver.powerSaver = true;
+        QTest::newRow("mains") << mains() << int(PowerPolicy::kNormal);
+        QTest::newRow("battery") << battery(80) << int(PowerPolicy::kReducedFps);
+        QTest::newRow("battery low") << battery(30) << int(PowerPolicy::kReducedResolution);
+        QTest::newRow("battery critical") << battery(15) << int(PowerPolicy::kPoster);
+        QTest::newRow("power saver") << saver << int(PowerPolicy::kReducedFps);
+        QTest::newRow("warm") << mains(75) << int(PowerPolicy::kReducedFps);
+        QTest::newRow("hot") << mains(85) << int(PowerPolicy::kReducedResolution);
+        QTest::newRow("critical") << mains(95) << int(PowerPolicy::kPaused);
+    }
+
+    void evaluate()
+    {
+        QFETCH(PowerState, state);
+        QFETCH(int, level);
+        QCOMPARE(int(PowerPolicy::evaluate(state, thresholds())), level);
+    }
+
+    void stepUpAtOnce()
+    {
+        auto provider = new FakePowerProvider;
+        PowerPolicy policy(provider, thresholds());
+        QCOMPARE(policy.level(), PowerPolicy::kNormal);
+
+        QSignalSpy spy(&policy, &PowerPolicy::levelChanged);
+        provider->setState(battery(80));
+        QCOMPARE(spy.count(), 1);
+        QCOMPARE(policy.level(), PowerPolicy::kReducedFps);
+
+        provider->setState(battery(10));
+        QCOMPARE(spy.count(), 2);
+        QCOMPARE(policy.level(), PowerPolicy::kPoster);
+    }
+
+    void stepDownAfterHold()
+    {
+        auto provider = new FakePowerProvider;
+        PowerPolicy policy(provider, thresholds());
+        provider->setState(battery(80));
+        QCOMPARE(policy.level(), PowerPolicy::kReducedFps);
+
+        QSignalSpy spy(&policy, &PowerPolicy::levelChanged);
+        provider->setState(mains());
+        QTest::qWait(500);
+        QCOMPARE(spy.count(), 0);
+        QCOMPARE(policy.level(), PowerPolicy::kReducedFps);
+
+        QTRY_COMPARE(policy.level(), PowerPolicy::kNormal);
+        QCOMPARE(spy.count(), 1);
+    }
+
+    void noFlapping()
+    {
+        auto provider = new FakePowerProvider;
+        PowerPolicy policy(provider, thresholds());
+        provider->setState(battery(80));
+
+        QSignalSpy spy(&policy, &PowerPolicy::levelChanged);
+        // the charger is plugged in and out again before the hold time.
+        provider->setState(mains());
+        QTest::qWait(600);
+        provider->setState(battery(80));
+        provider->setState(mains());
+        QTest::qWait(600);
+        QCOMPARE(spy.count(), 0);
+
+        // the hold time restarts after going back.
+        QTRY_COMPARE(policy.level(), PowerPolicy::kNormal);
+        QCOMPARE(spy.count(), 1);
+    }
+
+    void batteryMargin()
+    {
+        auto provider = new FakePowerProvider;
+        PowerPolicy policy(provider, thresholds());
+        provider->setState(battery(29));
+        QCOMPARE(policy.level(), PowerPolicy::kReducedResolution);
+
+        // above the threshold but within the margin.
+        provider->setState(battery(32));
+        QTest::qWait(1500);
+        QCOMPARE(policy.level(), PowerPolicy::kReducedResolution);
+
+        provider->setState(battery(36));
+        QTRY_COMPARE(policy.level(), PowerPolicy::kReducedFps);
+    }
+
+    void thermalMargin()
+    {
+        auto provider = new FakePowerProvider;
+        PowerPolicy policy(provider, thresholds());
+        provider->setState(mains(86));
+        QCOMPARE(policy.level(), PowerPolicy::kReducedResolution);
+
+        // below the threshold but within the margin.
+        provider->setState(mains(82));
+        QTest::qWait(1500);
+        QCOMPARE(policy.level(), PowerPolicy::kReducedResolution);
+
+        provider->setState(mains(79));
+        QTRY_COMPARE(policy.level(), PowerPolicy::kReducedFps);
+    }
+
+    void disabled()
+    {
+        auto provider = new FakePowerProvider;
+        PowerPolicy policy(provider, thresholds());
+        provider->setState(battery(10));
+        QCOMPARE(policy.level(), PowerPolicy::kPoster);
+
+        PowerThresholds thr = thresholds();
+        thr.enable = false;
+        policy.setThresholds(thr);
+        QTRY_COMPARE(policy.level(), PowerPolicy::kNormal);
+    }
+};
+
+QTEST_GUILESS_MAIN(TestPowerPolicy)
+
+#include "test_powerpolicy.moc"
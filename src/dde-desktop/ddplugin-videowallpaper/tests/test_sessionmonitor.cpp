@@ -0,0 +1,202 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "sessionmonitor.h"
+#include "ddplugin_videowallpaper_global.h"
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusObjectPath>
+#include <QProcess>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+
+namespace ddplugin_videowallpaper {
+DFM_LOG_REISGER_CATEGORY(DDP_VIDEOWALLPAPER_NAMESPACE)
+}
+
+using namespace ddplugin_videowallpaper;
+
+static constexpr char kSessionPath[] = "/org/freedesktop/login1/session/test";
+static constexpr char kOtherSessionPath[] = "/org/freedesktop/login1/session/other";
+
+// stand-in of logind.
+class LoginManager : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.login1.Manager")
+public slots:
+    QDBusObjectPath GetSessionByPID(uint pid)
+    {
+        Q_UNUSED(pid)
+        return QDBusObjectPath(kSessionPath);
+    }
+};
+
+// stand-in of deepin session manager.
+class SessionManager : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "com.deepin.SessionManager")
+    Q_PROPERTY(bool Locked READ isLocked)
+public:
+    bool isLocked() const
+    {
+        return locked;
+    }
+    bool locked = true;
+};
+
+class TestSessionMonitor : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase()
+    {
+        const QString daemon = QStandardPaths::findExecutable("dbus-daemon");
+        if (daemon.isEmpty())
+            QSKIP("dbus-daemon is not found");
+
+        // a private bus standing for both the system and session bus.
+        bus.start(daemon, { "--session", "--nofork", "--print-address" });
+        QVERIFY(bus.waitForStarted());
+        QVERIFY(bus.waitForReadyRead(5000));
+        const QString address = QString::fromLatin1(bus.readLine()).trimmed();
+        QVERIFY(!address.isEmpty());
+
+        service = new QDBusConnection(QDBusConnection::connectToBus(address, "stand-in"));
+        client = new QDBusConnection(QDBusConnection::connectToBus(address, "client"));
+        QVERIFY(service->isConnected());
+        QVERIFY(client->isConnected());
+
+        QVERIFY(service->registerObject("/org/freedesktop/login1", &login, QDBusConnection::ExportAllSlots));
+        QVERIFY(service->registerObject("/com/deepin/SessionManager", &session, QDBusConnection::ExportAllProperties));
+        DBusSessionSource::Names names;
+        QVERIFY(service->registerService(names.login));
+        QVERIFY(service->registerService(names.screenSaver));
+        QVERIFY(service->registerService(names.sessionManager));
+
+        // one connected monitor which is turned off.
+        QVERIFY(drm.isValid());
+        QVERIFY(QDir(drm.path()).mkpath("card0-HDMI-A-1"));
+        writeFile("card0-HDMI-A-1/status", "connected\n");
+        writeFile("card0-HDMI-A-1/dpms", "Off\n");
+        names.drm = drm.path();
+
+        source = new DBusSessionSource(*client, *client, names);
+        // the initial state may come before the test of lock.
+        lockSpy = new QSignalSpy(source, &AbstractSessionSource::lockChanged);
+    }
+
+    void cleanupTestCase()
+    {
+        delete lockSpy;
+        lockSpy = nullptr;
+        delete source;
+        source = nullptr;
+        if (service) {
+            QDBusConnection::disconnectFromBus("stand-in");
+            QDBusConnection::disconnectFromBus("client");
+            delete service;
+            delete client;
+        }
+        bus.kill();
+        bus.waitForFinished();
+    }
+
+    void lock()
+    {
+        QSignalSpy &spy = *lockSpy;
+        // the initial state is read from the deepin session manager, after our session is resolved.
+        QTRY_COMPARE(spy.count(), 1);
+        QCOMPARE(spy.at(0).at(0).toBool(), true);
+
+        // dde-lock unlocks without logind.
+        session.locked = false;
+        sendSignal("/com/deepin/SessionManager", "org.freedesktop.DBus.Properties", "PropertiesChanged",
+                   { QString("com.deepin.SessionManager"), QVariantMap { { "Locked", false } }, QStringList() });
+        QTRY_COMPARE(spy.count(), 2);
+        QCOMPARE(spy.at(1).at(0).toBool(), false);
+
+        // other sessions are ignored.
+        sendSignal(kOtherSessionPath, "org.freedesktop.login1.Session", "Lock", {});
+        QTest::qWait(200);
+        QCOMPARE(spy.count(), 2);
+
+        sendSignal(kSessionPath, "org.freedesktop.login1.Session", "Lock", {});
+        QTRY_COMPARE(spy.count(), 3);
+        QCOMPARE(spy.at(2).at(0).toBool(), true);
+
+        sendSignal(kSessionPath, "org.freedesktop.login1.Session", "Unlock", {});
+        QTRY_COMPARE(spy.count(), 4);
+        QCOMPARE(spy.at(3).at(0).toBool(), false);
+
+        // reported by both of them, only changed once.
+        sendSignal("/com/deepin/SessionManager", "org.freedesktop.DBus.Properties", "PropertiesChanged",
+                   { QString("com.deepin.SessionManager"), QVariantMap { { "Locked", false } }, QStringList() });
+        QTest::qWait(200);
+        QCOMPARE(spy.count(), 4);
+    }
+
+    void idleAndBlank()
+    {
+        QSignalSpy idle(source, &AbstractSessionSource::idleChanged);
+        QSignalSpy blank(source, &AbstractSessionSource::blankChanged);
+
+        sendSignal("/org/freedesktop/ScreenSaver", "org.freedesktop.ScreenSaver", "ActiveChanged", { true });
+        QTRY_COMPARE(idle.count(), 1);
+        QCOMPARE(idle.at(0).at(0).toBool(), true);
+        // the monitors are checked once it gets idle.
+        QTRY_COMPARE(blank.count(), 1);
+        QCOMPARE(blank.at(0).at(0).toBool(), true);
+
+        sendSignal("/org/freedesktop/ScreenSaver", "org.freedesktop.ScreenSaver", "ActiveChanged", { false });
+        QTRY_COMPARE(idle.count(), 2);
+        QCOMPARE(idle.at(1).at(0).toBool(), false);
+        QTRY_COMPARE(blank.count(), 2);
+        QCOMPARE(blank.at(1).at(0).toBool(), false);
+    }
+
+    void sleep()
+    {
+        QSignalSpy spy(source, &AbstractSessionSource::sleepChanged);
+        sendSignal("/org/freedesktop/login1", "org.freedesktop.login1.Manager", "PrepareForSleep", { true });
+        QTRY_COMPARE(spy.count(), 1);
+        QCOMPARE(spy.at(0).at(0).toBool(), true);
+
+        sendSignal("/org/freedesktop/login1", "org.freedesktop.login1.Manager", "PrepareForSleep", { false });
+        QTRY_COMPARE(spy.count(), 2);
+        QCOMPARE(spy.at(1).at(0).toBool(), false);
+    }
+
+private:
+    void writeFile(const QString &name, const QByteArray &data)
+    {
+        QFile file(drm.filePath(name));
+        QVERIFY(file.open(QFile::WriteOnly));
+        file.write(data);
+    }
+
+    void sendSignal(const QString &path, const QString &interface, const QString &name, const QVariantList &args)
+    {
+        QDBusMessage msg = QDBusMessage::createSignal(path, interface, name);
+        msg.setArguments(args);
+        QVERIFY(service->send(msg));
+    }
+
+    QProcess bus;
+    QDBusConnection *service = nullptr;
+    QDBusConnection *client = nullptr;
+    LoginManager login;
+    SessionManager session;
+    QTemporaryDir drm;
+    DBusSessionSource *source = nullptr;
+    QSignalSpy *lockSpy = nullptr;
+};
+
+QTEST_GUILESS_MAIN(TestSessionMonitor)
+
+#include "test_sessionmonitor.moc"
@@ -0,0 +1,290 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "transcodecache.h"
+#include "ddplugin_videowallpaper_global.h"
+
+#include <QtConcurrent>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+
+using namespace ddplugin_videowallpaper;
+
+// the head of file used in fingerprint.
+static constexpr qint64 kFingerprintBytes = 64 * 1024;
+// the renditions not requested are kept for other sizes and restarts until
+// they are unused for days or the cache is over budget.
+static constexpr int kUnusedDays = 30;
+static constexpr qint64 kCacheBudget = 4LL * 1024 * 1024 * 1024;
+
+TranscodeCache::TranscodeCache(QObject *parent) : QObject(parent)
+{
+
+}
+
+TranscodeCache::~TranscodeCache()
+{
+    if (watcher) {
+        watcher->disconnect(this);
+        watcher->waitForFinished();
+        delete watcher;
+        watcher = nullptr;
+    }
+
+    tasks.clear();
+    if (process) {
+        process->disconnect(this);
+        process->kill();
+        process->waitForFinished(1000);
+        QFile::remove(running.output + ".part");
+    }
+}
+
+QString TranscodeCache::cacheDir()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/deepin/dde-desktop/video-wallpaper";
+}
+
+QString TranscodeCache::fingerprint(const QString &file)
+{
+    QFile src(file);
+    if (!src.open(QFile::ReadOnly))
+        return QString();
+
+    QFileInfo info(file);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray::number(info.size()));
+    hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    hash.addData(src.read(kFingerprintBytes));
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString TranscodeCache::cacheFile(const QString &fp, const QSize &target)
+{
+    return QString("%0/%1-%2x%3.mp4").arg(cacheDir()).arg(fp).arg(target.width()).arg(target.height());
+}
+
+QString TranscodeCache::fileKey(const QFileInfo &info)
+{
+    return info.absoluteFilePath() + QString::number(info.lastModified().toMSecsSinceEpoch());
+}
+
+QUrl TranscodeCache::lookup(const QUrl &source, const QSize &target) const
+{
+    if (!source.isLocalFile() || target.isEmpty())
+        return source;
+
+    // the fingerprints are made in worker, the source is played until then.
+    const QString fp = fingerprints.value(fileKey(QFileInfo(source.toLocalFile())));
+    if (fp.isEmpty())
+        return source;
+
+    const QString cached = cacheFile(fp, target);
+    return QFileInfo::exists(cached) ? QUrl::fromLocalFile(cached) : source;
+}
+
+void TranscodeCache::request(const QList<QUrl> &sources, const QSize &target, const MediaInfoMap &infos)
+{
+    if (target.isEmpty())
+        return;
+
+    // ffmpeg is only recommended by the package.
+    if (QStandardPaths::findExecutable("ffmpeg").isEmpty()) {
+        if (!warned)
+            fmWarning() << "ffmpeg is not found, the transcoding cache is disabled.";
+        warned = true;
+        return;
+    }
+    warned = false;
+
+    Request req { sources, target, infos };
+    if (watcher) {
+        pending = req;
+        hasPending = true;
+        return;
+    }
+
+    watcher = new QFutureWatcher<Prepared>(this);
+    connect(watcher, &QFutureWatcher<Prepared>::finished, this, &TranscodeCache::prepared);
+    const QHash<QString, QString> known = fingerprints;
+    watcher->setFuture(QtConcurrent::run([req, known]() {
+        return TranscodeCache::prepare(req, known);
+    }));
+}
+
+TranscodeCache::Prepared TranscodeCache::prepare(const Request &req, const QHash<QString, QString> &known)
+{
+    Prepared ret;
+    QDir().mkpath(cacheDir());
+
+    QStringList keep;
+    for (const QUrl &url : req.sources) {
+        if (!url.isLocalFile())
+            continue;
+
+        const QString file = url.toLocalFile();
+        const QString key = fileKey(QFileInfo(file));
+        QString fp = known.value(key);
+        const bool isNew = fp.isEmpty();
+        if (isNew)
+            fp = fingerprint(file);
+        if (fp.isEmpty())
+            continue;
+        ret.fingerprints.insert(key, fp);
+
+        const QString cached = cacheFile(fp, req.target);
+        if (QFileInfo::exists(cached)) {
+            // the time of use for pruning.
+            QFile file(cached);
+            if (file.open(QFile::ReadWrite))
+                file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+            keep.append(cached);
+            ret.found = ret.found || isNew;
+            continue;
+        }
+
+        // downscaling only, a small source is played as it is.
+        const QSize res = req.infos.value(file).resolution;
+        if (res.isValid() && res.width() <= req.target.width() && res.height() <= req.target.height())
+            continue;
+
+        Task task;
+        task.source = file;
+        task.output = cached;
+        task.target = req.target;
+        keep.append(task.output);
+        ret.tasks.append(task);
+    }
+
+    prune(keep);
+    return ret;
+}
+
+void TranscodeCache::prepared()
+{
+    const Prepared result = watcher->result();
+    watcher->deleteLater();
+    watcher = nullptr;
+
+    // the fingerprints of the files no longer requested are dropped.
+    fingerprints = result.fingerprints;
+    tasks.clear();
+    for (const Task &task : result.tasks) {
+        if (!process || running.output != task.output)
+            tasks.enqueue(task);
+    }
+
+    if (hasPending) {
+        hasPending = false;
+        request(pending.sources, pending.target, pending.infos);
+    }
+
+    if (result.found)
+        emit cacheUpdated();
+
+    next();
+}
+
+void TranscodeCache::next()
+{
+    if (process || tasks.isEmpty())
+        return;
+
+    running = tasks.dequeue();
+    fmInfo() << "transcode" << running.source << "to" << running.output;
+
+    // a loop friendly rendition: no audio, short GOP and fitting the screen.
+    // it is always H.264: every hwdec (vaapi, vdpau, nvdec) decodes it, and without
+    // hwdec it is still the cheapest codec for software decoding at the size of screen.
+    // the size is capped by the source in case its resolution was unknown.
+    const QString scale = QString("scale=w='min(iw,%0)':h='min(ih,%1)':force_original_aspect_ratio=decrease,setsar=1")
+            .arg(running.target.width()).arg(running.target.height());
+    const QStringList args {
+        "-nostdin", "-y", "-loglevel", "error",
+        "-i", running.source,
+        "-an", "-sn", "-dn",
+        "-vf", scale,
+        "-c:v", "libx264", "-preset", "veryfast", "-crf", "23", "-pix_fmt", "yuv420p",
+        "-g", "30", "-keyint_min", "30", "-sc_threshold", "0",
+        "-movflags", "+faststart",
+        "-f", "mp4", running.output + ".part"
+    };
+
+    process = new QProcess(this);
+    connect(process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+            this, &TranscodeCache::finished);
+    // finished is not emitted if it is not started.
+    connect(process, &QProcess::errorOccurred, this, &TranscodeCache::failedToStart);
+
+    // run in lowest priority.
+    process->start("nice", QStringList { "-n", "19", "ffmpeg" } + args);
+}
+
+void TranscodeCache::finished(int code, QProcess::ExitStatus status)
+{
+    const QString part = running.output + ".part";
+    if (status == QProcess::NormalExit && code == 0 && QFile::rename(part, running.output)) {
+        fmInfo() << "transcoded" << running.output;
+        emit cacheUpdated();
+    } else {
+        fmWarning() << "fail to transcode" << running.source << code << process->readAllStandardError();
+        QFile::remove(part);
+    }
+
+    process->deleteLater();
+    process = nullptr;
+    running = Task();
+    next();
+}
+
+void TranscodeCache::failedToStart(QProcess::ProcessError error)
+{
+    if (error != QProcess::FailedToStart)
+        return;
+
+    // the others would fail in the same way, they are requested again with the sources.
+    fmWarning() << "can not start ffmpeg, drop" << tasks.size() + 1 << "tasks:" << process->errorString();
+    QFile::remove(running.output + ".part");
+    process->deleteLater();
+    process = nullptr;
+    running = Task();
+    tasks.clear();
+}
+
+void TranscodeCache::prune(const QStringList &keep)
+{
+    QDir dir(cacheDir());
+    const QDateTime expired = QDateTime::currentDateTime().addDays(-kUnusedDays);
+    qint64 total = 0;
+    QFileInfoList unused;
+    // the least recently used first.
+    for (const QFileInfo &info : dir.entryInfoList({ "*.mp4" }, QDir::Files, QDir::Time | QDir::Reversed)) {
+        if (keep.contains(info.absoluteFilePath())) {
+            total += info.size();
+            continue;
+        }
+
+        if (info.lastModified() < expired) {
+            fmInfo() << "remove unused transcoded" << info.absoluteFilePath();
+            QFile::remove(info.absoluteFilePath());
+            continue;
+        }
+
+        total += info.size();
+        unused.append(info);
+    }
+
+    for (const QFileInfo &info : unused) {
+        if (total <= kCacheBudget)
+            break;
+
+        fmInfo() << "remove transcoded over budget" << info.absoluteFilePath();
+        QFile::remove(info.absoluteFilePath());
+        total -= info.size();
+    }
+}
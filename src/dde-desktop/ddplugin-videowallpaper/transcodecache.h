@@ -0,0 +1,77 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef TRANSCODECACHE_H
+#define TRANSCODECACHE_H
+
+#include <QObject>
+#include <QUrl>
+#include <QFileInfo>
+#include <QSize>
+#include <QProcess>
+#include <QQueue>
+#include <QFutureWatcher>
+
+#include "mediaindex.h"
+
+namespace ddplugin_videowallpaper {
+
+// transcodes the videos in background to the size of screen.
+class TranscodeCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TranscodeCache(QObject *parent = nullptr);
+    ~TranscodeCache() override;
+    static QString cacheDir();
+    static QString fingerprint(const QString &file);
+    static QString cacheFile(const QString &fingerprint, const QSize &target);
+    // the cached rendition, or the source if it is not ready.
+    QUrl lookup(const QUrl &source, const QSize &target) const;
+    // the sources no larger than target are played directly.
+    void request(const QList<QUrl> &sources, const QSize &target, const MediaInfoMap &infos);
+signals:
+    void cacheUpdated();
+protected slots:
+    void next();
+    void finished(int code, QProcess::ExitStatus status);
+    void failedToStart(QProcess::ProcessError error);
+    void prepared();
+protected:
+    struct Task
+    {
+        QString source;
+        QString output;
+        QSize target;
+    };
+    struct Request
+    {
+        QList<QUrl> sources;
+        QSize target;
+        MediaInfoMap infos;
+    };
+    struct Prepared
+    {
+        QList<Task> tasks;
+        QHash<QString, QString> fingerprints;
+        bool found = false;   // some renditions are found by new fingerprints
+    };
+    // reads the files, runs in worker thread.
+    static Prepared prepare(const Request &req, const QHash<QString, QString> &known);
+    static void prune(const QStringList &keep);
+    static QString fileKey(const QFileInfo &info);
+private:
+    QQueue<Task> tasks;
+    QProcess *process = nullptr;
+    Task running;
+    QHash<QString, QString> fingerprints;   // file and its time -- fingerprint
+    QFutureWatcher<Prepared> *watcher = nullptr;
+    Request pending;   // the request after the preparing one
+    bool hasPending = false;
+    bool warned = false;
+};
+
+}
+
+#endif // TRANSCODECACHE_H
@@ -6,45 +6,241 @@
 
 #include "dfm-base/dfm_desktop_defines.h"
 
+#include <QFileInfo>
 #include <QPaintEvent>
 #include <QPainter>
+#include <QElapsedTimer>
+
+#ifdef USE_LIBDMR
+#include <QtConcurrent>
+#endif
+
+#include <cmath>
 
 using namespace ddplugin_videowallpaper;
 DFMBASE_USE_NAMESPACE
 
 #ifdef USE_LIBDMR
+// the tap interval before the frame rate of decoder is known.
+static constexpr int kTapInterval = 40;
+// the recording starts at the beginning of a loop.
+static constexpr int kRingStartWindow = 100;   // ms
+// the decode path is measured after playing for a while.
+static constexpr int kProbeWindow = 3000;   // ms
+#endif
 
-VideoProxy::VideoProxy(QWidget *parent) : dmr::PlayerWidget(parent)
+VideoProxy::VideoProxy(QWidget *parent) : QWidget(parent)
 {
-    dmr::PlayerEngine &eng = engine();
-    eng.setMute(true);
-
     auto pal = palette();
-    pal.setBrush(backgroundRole(), Qt::black);
+    pal.setColor(backgroundRole(), Qt::black);
     setPalette(pal);
+    setAutoFillBackground(false);
+    // every pixel is painted by paintEvent, Qt need not to compose the background.
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setAttribute(Qt::WA_NoSystemBackground);
 
-    // do not decode audio
-    _engine->setBackendProperty("ao", "no");
-    _engine->setBackendProperty("color", QVariant::fromValue(QColor(Qt::black)));
-    _engine->setBackendProperty("keep-open", "yes");
-    _engine->setBackendProperty("dmrhwdec-switch", true);
+#ifdef USE_LIBDMR
+    // interval of grabbing frames for the widgets sharing this decoder.
+    tapTimer.setInterval(kTapInterval);
+    connect(&tapTimer, &QTimer::timeout, this, &VideoProxy::tapFrame);
+    tapPool.setMaxThreadCount(1);
 
-    connect(_engine, &dmr::PlayerEngine::stateChanged, this, &VideoProxy::playNext);
+    // the player is created only if this widget decodes a distinct stream, see setSource().
+#endif
 }
 
 VideoProxy::~VideoProxy()
 {
+#ifdef USE_LIBDMR
     stop();
+#endif
+}
+
+void VideoProxy::updateImage(const QImage &img)
+{
+    image = img;
+    counters()->presented.fetchAndAddRelaxed(1);
+
+    // the bars are repainted only if the video rect is changed.
+    const QRect old = videoRect;
+    videoRect = imageRect();
+    if (videoRect != old)
+        update();
+    else
+        update(videoRect);
+
+    if (!image.isNull())
+        setFrameReady();
+}
+
+bool VideoProxy::hasFrame() const
+{
+    return ready;
+}
+
+void VideoProxy::setSuspended(bool s)
+{
+    if (suspended == s)
+        return;
+
+    suspended = s;
+    if (suspended) {
+        image = QImage();
+        videoRect = QRect();
+        ready = false;
+    }
+
+#ifdef USE_LIBDMR
+    if (suspended) {
+        stopRing();
+        delete standby;
+        standby = nullptr;
+        standbyUrl.clear();
+    } else {
+        prepareStandby();
+    }
+
+    // mpv keeps the demuxed packets while paused, restore its defaults after resuming.
+    if (player) {
+        dmr::PlayerEngine &eng = player->engine();
+        eng.setBackendProperty("demuxer-max-bytes", suspended ? "1MiB" : "150MiB");
+        eng.setBackendProperty("demuxer-max-back-bytes", suspended ? "0" : "50MiB");
+    }
+#endif
+}
+
+qint64 VideoProxy::imageBytes() const
+{
+    return image.sizeInBytes();
+}
+
+void VideoProxy::setSpanRegion(const QRectF &region)
+{
+    if (span == region)
+        return;
+
+    span = region;
+#ifdef USE_LIBDMR
+    // the decoder shows its part of the frame by panning.
+    updateFilters();
+#endif
+}
+
+QRectF VideoProxy::spanRegion() const
+{
+    return span;
+}
+
+void VideoProxy::setFrameReady()
+{
+    if (ready)
+        return;
+
+    ready = true;
+    emit frameShown();
+}
+
+QSize VideoProxy::frameSize() const
+{
+    return size() * devicePixelRatioF();
+}
+
+StageCounters *VideoProxy::counters()
+{
+    if (perf)
+        return perf;
+
+    // the name is set after creating.
+    const QString name = property(DesktopFrameProperty::kPropScreenName).toString();
+    if (name.isEmpty())
+        return PerfCounters::instance()->stage("unknown");
+
+    perf = PerfCounters::instance()->stage(name);
+    return perf;
+}
+
+void VideoProxy::paintEvent(QPaintEvent *e)
+{
+    QElapsedTimer timer;
+    timer.start();
+    paintImage(e->region());
+    counters()->paint.add(timer.nsecsElapsed());
+}
+
+void VideoProxy::resizeEvent(QResizeEvent *e)
+{
+    QWidget::resizeEvent(e);
+    videoRect = imageRect();
+#ifdef USE_LIBDMR
+    // the frames in ring are scaled for the old size.
+    if (ring && ring->state() != FrameRing::kIdle && e->size() != e->oldSize())
+        stopRing();
+
+    if (player)
+        player->setGeometry(rect());
+    if (standby)
+        standby->setGeometry(rect());
+
+    // the crop depends on the size of widget.
+    updateFilters();
+#endif
 }
 
+QRect VideoProxy::imageRect() const
+{
+    if (image.isNull())
+        return QRect();
+
+    QSize tar = image.size() / devicePixelRatioF();
+    int x = (width() - tar.width()) / 2.0;
+    int y = (height() - tar.height()) / 2.0;
+    x = x < 0 ? 0 : x;
+    y = y < 0 ? 0 : y;
+    return QRect(QPoint(x, y), tar);
+}
+
+void VideoProxy::paintImage(const QRegion &region)
+{
+    QPainter pa(this);
+    if (image.isNull()) {
+        pa.fillRect(rect(), palette().background());
+        return;
+    }
+
+    // only the exposed bars, they are not in the region of a new frame.
+    const QRegion bars = region.subtracted(videoRect);
+    for (const QRect &r : bars)
+        pa.fillRect(r, palette().background());
+
+    pa.drawImage(videoRect.topLeft(), image);
+}
+
+#ifdef USE_LIBDMR
+
 void VideoProxy::setPlayList(const QList<QUrl> &list)
 {
+    if (list != playList)
+        stopRing();
+
+    // the playing one is not interrupted unless its file is removed.
+    const int idx = playList.indexOf(current);
     playList = list;
-    if (list.contains(current))
+    updateLoop();
+    if (list.contains(current)) {
+        prepareStandby();
+        return;
+    }
+
+    if (run && !list.isEmpty() && current.isLocalFile() && QFileInfo::exists(current.toLocalFile())) {
+        position = qMax(idx, 0);
+        prepareStandby();
         return;
+    }
 
-    _engine->stop();
-    _engine->getplaylist()->clear();
+    if (player) {
+        player->engine().stop();
+        player->engine().getplaylist()->clear();
+    }
 
     play();
 }
@@ -62,89 +258,810 @@ void VideoProxy::play()
 
     run = true;
     current = next;
-    PlayerWidget::play(next);
 
-    QString hd =_engine->getBackendProperty("hwdec").toString();
+    // the frames come from source.
+    if (!player)
+        return;
+
+    updateLoop();
+    applyDecodePath(player, next);
+    player->play(next);
+    beginProbe(next, true);
+    if (paused)
+        player->engine().setBackendProperty("pause", true);
+
+    QString hd = player->engine().getBackendProperty("hwdec").toString();
     fmDebug() << "play" << next << "hardward decode" << hd;
+    prepareStandby();
 }
 
 void VideoProxy::stop()
 {
     run = false;
-    _engine->stop();
+    stopRing();
+    tapTimer.stop();
+    waitTap();
+    if (player)
+        player->engine().stop();
+
+    if (standby) {
+        standby->engine().stop();
+        standbyUrl.clear();
+    }
+}
+
+void VideoProxy::setSource(VideoProxy *src)
+{
+    if (src == this)
+        src = nullptr;
+
+    if (decoder == src && (src || player))
+        return;
+
+    decoder = src;
+    if (src) {
+        fmInfo() << "share decoder of" << src->property(DesktopFrameProperty::kPropScreenName).toString()
+                 << "with" << property(DesktopFrameProperty::kPropScreenName).toString();
+        setMirrored(false);
+        stopRing();
+        destroyPlayer();
+    } else {
+        image = QImage();
+        videoRect = QRect();
+        createPlayer();
+        if (run) {
+            current.clear();
+            play();
+        }
+    }
+}
+
+VideoProxy *VideoProxy::source() const
+{
+    return decoder.data();
+}
+
+bool VideoProxy::isDecoding() const
+{
+    return player != nullptr;
+}
+
+void VideoProxy::setMirrored(bool m)
+{
+    mirrored = m;
+    updateTap();
+}
+
+void VideoProxy::setMaxFps(int fps)
+{
+    fps = qMax(fps, 0);
+    if (maxFps == fps)
+        return;
+
+    maxFps = fps;
+    updateTapInterval();
+    updateFilters();
+}
+
+void VideoProxy::setDecodeScale(qreal scale)
+{
+    scale = qBound(0.1, scale, 1.0);
+    if (qFuzzyCompare(decodeScale, scale))
+        return;
+
+    decodeScale = scale;
+    updateFilters();
+}
+
+void VideoProxy::setPaused(bool p)
+{
+    if (paused == p)
+        return;
+
+    paused = p;
+    if (ring && ring->state() == FrameRing::kReady) {
+        if (paused)
+            ring->stop();
+        else
+            ring->play();
+        return;
+    }
+
+    if (player && player->engine().state() != dmr::PlayerEngine::Idle)
+        player->engine().setBackendProperty("pause", paused);
+}
+
+const GapMeter &VideoProxy::transitionGap() const
+{
+    return gap;
+}
+
+QVariantMap VideoProxy::decoderStats() const
+{
+    QVariantMap ret;
+    ret.insert("current", current.toString());
+    ret.insert("fromRing", player && player->isHidden());
+    if (ring) {
+        ret.insert("ringBytes", ring->bytes());
+        ret.insert("ringFrames", ring->count());
+        ret.insert("ringEvictions", ring->evictions());
+    }
+
+    QVariantMap gapMap;
+    gapMap.insert("lastMs", gap.last());
+    gapMap.insert("maxMs", gap.max());
+    gapMap.insert("avgMs", gap.average());
+    gapMap.insert("count", gap.count());
+    gapMap.insert("overFrame", gap.overruns());
+    ret.insert("transitionGap", gapMap);
+
+    if (!player)
+        return ret;
+
+    dmr::PlayerEngine &eng = player->engine();
+    ret.insert("hwdec", eng.getBackendProperty("hwdec-current").toString());
+    ret.insert("decoded", eng.getBackendProperty("estimated-frame-number").toLongLong());
+    ret.insert("dropped", eng.getBackendProperty("frame-drop-count").toLongLong()
+               + eng.getBackendProperty("decoder-frame-drop-count").toLongLong());
+    ret.insert("late", eng.getBackendProperty("vo-delayed-frame-count").toLongLong());
+    ret.insert("fps", eng.getBackendProperty("estimated-vf-fps").toDouble());
+    return ret;
+}
+
+void VideoProxy::setFrameCache(bool enable, qint64 maxLength, qint64 budget)
+{
+    if (!enable) {
+        stopRing();
+        delete ring;
+        ring = nullptr;
+        updateTap();
+        return;
+    }
+
+    if (!ring) {
+        ring = new FrameRing(this);
+        connect(ring, &FrameRing::frameReady, this, &VideoProxy::playRingFrame);
+        // go back to decoder if the budget is exceeded.
+        connect(ring, &FrameRing::evicted, this, [this]() {
+            ringRejected = current;
+            stopRing();
+        });
+    }
+
+    if (ringMaxLength != maxLength)
+        ringRejected.clear();
+    ringMaxLength = maxLength;
+    ring->setBudget(budget);
+    updateRing();
 }
 
 void VideoProxy::playNext()
 {
-    auto stat = _engine->state();
-    if (run && stat != dmr::PlayerEngine::Playing) {
+    if (!player)
+        return;
+
+    // the next item is loaded in standby player, hold it at the first frame.
+    if (standby && sender() == &standby->engine()) {
+        if (standby->engine().state() == dmr::PlayerEngine::Playing)
+            standby->engine().setBackendProperty("pause", true);
+        return;
+    }
+
+    // the decoder is stopped while playing from ring.
+    if (player->isHidden())
+        return;
+
+    dmr::PlayerEngine &eng = player->engine();
+    auto stat = eng.state();
+    if (stat == dmr::PlayerEngine::Playing) {
+        if (gap.isRunning()) {
+            const qreal fps = eng.getBackendProperty("container-fps").toDouble();
+            gap.finish(fps > 0 ? 1000 / fps : 0);
+        }
+        updateSourceSize();
+        updateTapInterval();
+        updateRing();
+        setFrameReady();
+        if (!probing.isEmpty() && probing == current) {
+            const qint64 startup = probeOpened ? probeTimer.elapsed() : -1;
+            const QUrl url = probing;
+            probing.clear();
+            QTimer::singleShot(kProbeWindow, this, [this, url, startup]() {
+                finishProbe(url, startup);
+            });
+        }
+        return;
+    }
+
+    if (paused)
+        return;
+
+    if (run) {
         if (playList.isEmpty()) {
-            _engine->getplaylist()->clear();
+            eng.getplaylist()->clear();
             current.clear();
             return;
         }
 
-        // 循环播放
-        if (playList.size() == 1 && stat == dmr::PlayerEngine::Paused) {
-            engine().seekAbsolute(0);
-            engine().pauseResume();
+        // 循环播放, mpv loops the single file by loop-file, this is the fallback.
+        if (playList.size() == 1 && playList.first() == current && stat == dmr::PlayerEngine::Paused) {
+            eng.seekAbsolute(0);
+            eng.pauseResume();
             return;
         }
 
         // 播放下一个
-        int idx = playList.indexOf(current);
-        if (idx < 0 || idx >= playList.size() - 1)
-            idx = 0;
-        else
-            idx++;
+        switchTo(playList.at(nextIndex()));
+    }
+}
 
-        _engine->getplaylist()->clear();
-        current = playList.at(idx);
-        PlayerWidget::play(current);
+void VideoProxy::switchTo(const QUrl &next)
+{
+    current = next;
+    gap.start();
+    if (standby && standbyUrl == current) {
+        // the standby player has opened the file and decoded its first frame,
+        // the frame being read back belongs to the old one.
+        waitTap();
+        std::swap(player, standby);
+        standbyUrl.clear();
+        player->raise();
+        player->engine().setBackendProperty("pause", paused);
 
-        QString hd =_engine->getBackendProperty("hwdec").toString();
-        fmDebug() << "play" << current << "hardward decode" << hd;
+        standby->engine().stop();
+        standby->engine().getplaylist()->clear();
+        beginProbe(current, false);
+    } else {
+        player->engine().getplaylist()->clear();
+        applyDecodePath(player, current);
+        player->play(current);
+        beginProbe(current, true);
     }
+
+    // the frame number starts again for the new item.
+    lastTapped = -1;
+    // the speed is corrected again for the new item.
+    playSpeed = 1.0;
+    player->engine().setBackendProperty("speed", playSpeed);
+
+    updateLoop();
+    QString hd = player->engine().getBackendProperty("hwdec").toString();
+    fmDebug() << "play" << current << "hardward decode" << hd;
+    prepareStandby();
+    emit itemChanged(playList.indexOf(current));
 }
 
-#else
+int VideoProxy::currentIndex() const
+{
+    return playList.indexOf(current);
+}
 
-VideoProxy::VideoProxy(QWidget *parent) : QWidget(parent)
+void VideoProxy::playIndex(int index)
 {
-    auto pal = palette();
-    pal.setColor(backgroundRole(), Qt::black);
-    setPalette(pal);
-    setAutoFillBackground(false);
+    if (!run || !player || player->isHidden() || index < 0 || index >= playList.size())
+        return;
+
+    if (playList.at(index) != current)
+        switchTo(playList.at(index));
 }
 
-VideoProxy::~VideoProxy()
+qint64 VideoProxy::position() const
 {
+    // invalid while opening the file or playing from ring.
+    if (!player || player->isHidden() || player->engine().state() != dmr::PlayerEngine::Playing)
+        return -1;
 
+    bool ok = false;
+    const double pos = player->engine().getBackendProperty("time-pos").toDouble(&ok);
+    return ok ? qRound64(pos * 1000) : -1;
 }
 
-void VideoProxy::updateImage(const QImage &img)
+qreal VideoProxy::frameInterval() const
+{
+    const qreal fps = player ? player->engine().getBackendProperty("container-fps").toDouble() : 0;
+    return fps > 0 ? 1000 / fps : 40;
+}
+
+void VideoProxy::setSpeed(qreal speed)
+{
+    if (!player || qFuzzyCompare(playSpeed, speed))
+        return;
+
+    playSpeed = speed;
+    player->engine().setBackendProperty("speed", speed);
+}
+
+void VideoProxy::seekTo(qint64 ms)
+{
+    if (player)
+        player->engine().setBackendProperty("time-pos", ms / 1000.0);
+}
+
+void VideoProxy::tapFrame()
+{
+    // the tick is skipped if the last readback is not finished.
+    if (!player || tapping || player->engine().state() != dmr::PlayerEngine::Playing)
+        return;
+
+    dmr::PlayerEngine *eng = &player->engine();
+    const QSize ringSize = ring && ring->state() == FrameRing::kRecording ? frameSize() : QSize();
+    const qreal ratio = devicePixelRatioF();
+    const qint64 last = lastTapped;
+
+    tapping = new QFutureWatcher<TapResult>(this);
+    connect(tapping, &QFutureWatcher<TapResult>::finished, this, &VideoProxy::finishTap);
+    // the client API of mpv is thread safe, the frame is read back without blocking the GUI thread.
+    tapping->setFuture(QtConcurrent::run(&tapPool, [eng, ringSize, ratio, last]() {
+        TapResult ret;
+        // no new frame is presented since the last tap.
+        ret.number = eng->getBackendProperty("estimated-frame-number").toLongLong();
+        if (ret.number > 0 && ret.number == last)
+            return ret;
+
+        ret.pts = qRound64(eng->getBackendProperty("time-pos").toDouble() * 1000);
+        ret.frame = eng->takeScreenshot();
+        if (!ret.frame.isNull() && ringSize.isValid()) {
+            ret.ringFrame = ret.frame.scaled(ringSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+            ret.ringFrame.setDevicePixelRatio(ratio);
+        }
+        return ret;
+    }));
+}
+
+void VideoProxy::finishTap()
+{
+    const TapResult ret = tapping->result();
+    tapping->deleteLater();
+    tapping = nullptr;
+    if (ret.frame.isNull() || !player)
+        return;
+
+    lastTapped = ret.number;
+    if (ring && ring->state() == FrameRing::kRecording && !ret.ringFrame.isNull())
+        recordFrame(ret.ringFrame, ret.pts);
+
+    if (mirrored)
+        emit frameReady(ret.frame);
+}
+
+void VideoProxy::waitTap()
+{
+    // the engine must not be released while reading it back.
+    if (!tapping)
+        return;
+
+    tapping->disconnect(this);
+    tapping->waitForFinished();
+    delete tapping;
+    tapping = nullptr;
+}
+
+void VideoProxy::updateTapInterval()
+{
+    // one tap for each frame of decoder, the frames beyond the limit are dropped already.
+    qreal interval = player ? frameInterval() : kTapInterval;
+    if (maxFps > 0)
+        interval = qMax(interval, 1000.0 / maxFps);
+    tapTimer.setInterval(qMax(qRound(interval), 1));
+}
+
+void VideoProxy::playRingFrame(const QImage &img)
+{
+    updateImage(img);
+    if (mirrored)
+        emit frameReady(img);
+}
+
+void VideoProxy::stopRing()
+{
+    // the player is hidden while playing from ring.
+    const bool fromRing = player && player->isHidden();
+    if (ring)
+        ring->clear();
+    lastPts = -1;
+    updateTap();
+    if (!fromRing)
+        return;
+
+    // restart the decoder.
+    fmInfo() << "resume decoding" << current;
+    image = QImage();
+    videoRect = QRect();
+    player->show();
+    if (run) {
+        updateLoop();
+        player->play(current);
+        if (paused)
+            player->engine().setBackendProperty("pause", true);
+    }
+}
+
+void VideoProxy::updateTap()
+{
+    const bool recording = ring && ring->state() == FrameRing::kRecording;
+    if ((mirrored || recording) && player)
+        tapTimer.start();
+    else
+        tapTimer.stop();
+}
+
+void VideoProxy::updateRing()
+{
+    if (!ring || !player || ring->state() != FrameRing::kIdle)
+        return;
+
+    if (playList.size() != 1 || current != playList.first() || ringRejected == current)
+        return;
+
+    dmr::PlayerEngine &eng = player->engine();
+    const qint64 duration = qRound64(eng.getBackendProperty("duration").toDouble() * 1000);
+    if (duration <= 0)
+        return;
+
+    if (duration > ringMaxLength) {
+        ringRejected = current;
+        return;
+    }
+
+    fmInfo() << "record frames of" << current << duration << "ms";
+    ring->start();
+    lastPts = -1;
+    updateTap();
+}
+
+void VideoProxy::recordFrame(const QImage &img, qint64 pts)
+{
+    dmr::PlayerEngine &eng = player->engine();
+
+    // wait for the beginning of a loop.
+    if (lastPts < 0 && pts > kRingStartWindow)
+        return;
+
+    // the clip looped, all frames are kept.
+    if (lastPts >= 0 && pts < lastPts) {
+        const qint64 duration = qRound64(eng.getBackendProperty("duration").toDouble() * 1000);
+        if (!ring->finish(duration)) {
+            ringRejected = current;
+            updateTap();
+            return;
+        }
+
+        // shut down the decoder, the frames come from ring.
+        fmInfo() << "stop decoding" << current;
+        delete standby;
+        standby = nullptr;
+        standbyUrl.clear();
+        player->hide();
+        eng.stop();
+        updateTap();
+        if (!paused)
+            ring->play();
+        return;
+    }
+
+    lastPts = pts;
+    if (!ring->append(img, pts)) {
+        ringRejected = current;
+        updateTap();
+    }
+}
+
+dmr::PlayerWidget *VideoProxy::newPlayer()
+{
+    auto wid = new dmr::PlayerWidget(this);
+    wid->setGeometry(rect());
+
+    auto pal = wid->palette();
+    pal.setBrush(wid->backgroundRole(), Qt::black);
+    wid->setPalette(pal);
+
+    dmr::PlayerEngine &eng = wid->engine();
+    eng.setMute(true);
+
+    // do not decode audio
+    eng.setBackendProperty("ao", "no");
+    eng.setBackendProperty("color", QVariant::fromValue(QColor(Qt::black)));
+    eng.setBackendProperty("keep-open", "yes");
+    eng.setBackendProperty("dmrhwdec-switch", true);
+    // let decoder drop the late frames.
+    eng.setBackendProperty("framedrop", "decoder+vo");
+
+    connect(&eng, &dmr::PlayerEngine::stateChanged, this, &VideoProxy::playNext);
+    return wid;
+}
+
+void VideoProxy::createPlayer()
+{
+    if (player)
+        return;
+
+    player = newPlayer();
+    playSpeed = 1.0;
+    videoFilters.clear();
+    updateFilters();
+    player->show();
+}
+
+void VideoProxy::destroyPlayer()
 {
-    image = img.scaled(size() * devicePixelRatioF(), Qt::KeepAspectRatio);
-    image.setDevicePixelRatio(devicePixelRatioF());
+    if (!player)
+        return;
+
+    tapTimer.stop();
+    waitTap();
+    player->engine().stop();
+    delete player;
+    player = nullptr;
+
+    delete standby;
+    standby = nullptr;
+    standbyUrl.clear();
     update();
 }
 
-void VideoProxy::paintEvent(QPaintEvent *e)
+int VideoProxy::nextIndex() const
 {
-    QPainter pa(this);
-    auto fill = QRect(QPoint(0,0), size());
-    pa.fillRect(fill, palette().background());
+    int idx = playList.indexOf(current);
+    // the playing one was replaced, go on from its position.
+    if (idx < 0)
+        idx = position;
 
-    if (image.isNull())
+    return idx + 1 < playList.size() ? idx + 1 : 0;
+}
+
+void VideoProxy::updateLoop()
+{
+    // mpv loops the single file without reopening it.
+    if (player)
+        player->engine().setBackendProperty("loop-file", playList.size() == 1 ? "inf" : "no");
+}
+
+void VideoProxy::prepareStandby()
+{
+    if (!player || !run || playList.size() < 2 || suspended || !preroll) {
+        delete standby;
+        standby = nullptr;
+        standbyUrl.clear();
         return;
-    QSize tar = image.size() / devicePixelRatioF();
+    }
 
-    int x = (fill.width() - tar.width()) / 2.0;
-    int y = (fill.height() - tar.height()) / 2.0;
-    x = x < 0 ? 0 : x;
-    y = y < 0 ? 0 : y;
+    const QUrl next = playList.at(nextIndex());
+    if (standby && standbyUrl == next)
+        return;
+
+    if (!standby) {
+        standby = newPlayer();
+        videoFilters.clear();
+        updateFilters();
+    }
+
+    // it is under the playing one and shows the first frame of next item.
+    standby->stackUnder(player);
+    standby->show();
+
+    standbyUrl = next;
+    dmr::PlayerEngine &eng = standby->engine();
+    eng.setBackendProperty("pause", true);
+    eng.stop();
+    eng.getplaylist()->clear();
+    applyDecodePath(standby, next);
+    standby->play(next);
+    fmDebug() << "preload" << next;
+}
+
+void VideoProxy::updateFilters()
+{
+    if (!player)
+        return;
+
+    QStringList filters;
+    // drop the frames beyond the limit in the decoder, they are neither uploaded nor rendered.
+    if (maxFps > 0)
+        filters.append(QString("fps=%0").arg(maxFps));
+
+    const ScaleGeometry geo = ScaleGeometry::compute(sourceSize, outputSize.isValid() ? outputSize : frameSize(), scaleMode);
+    const bool spanning = !span.isEmpty();
+    // the software filters would download the frames decoded by hardware,
+    // so they are cropped and scaled by vo then.
+    const bool gpu = framesInGpu();
+    qreal zoom = 0;
+    QPointF pan;
+    qreal aspect = -1;   // of the source
+    if (!gpu) {
+        // the invisible part is cropped before scaling and uploading.
+        if (sourceSize.isValid() && geo.source != QRect(QPoint(0, 0), sourceSize)) {
+            filters.append(QString("crop=%0:%1:%2:%3").arg(geo.source.width()).arg(geo.source.height())
+                           .arg(geo.source.x()).arg(geo.source.y()));
+        }
+
+        // scaled to the pixels of screen right after decoding, the frames are never scaled up.
+        // the size is unknown before the first frame, only the decode scale is applied.
+        if (sourceSize.isValid() && !geo.target.isEmpty()) {
+            const QSize out(qRound(qMin(geo.target.width(), geo.source.width()) * decodeScale),
+                            qRound(qMin(geo.target.height(), geo.source.height()) * decodeScale));
+            if (out != geo.source.size())
+                filters.append(QString("scale=w=%0:h=%1").arg(qMax(out.width() & ~1, 2)).arg(qMax(out.height() & ~1, 2)));
+        } else if (decodeScale < 1.0) {
+            filters.append(QString("scale=w=trunc(iw*%0/2)*2:h=-2").arg(decodeScale));
+        }
+
+        // the scaled frame has the shape of canvas even if it is stretched.
+        if (spanning)
+            filters.append("setsar=1");
+    } else if (sourceSize.isValid() && !geo.target.isEmpty()) {
+        // the whole frame is kept, it is scaled in the surfaces of vaapi only.
+        if (hwdec == "vaapi") {
+            const qreal sx = qMin(1.0, qreal(geo.target.width()) / geo.source.width()) * decodeScale;
+            const qreal sy = qMin(1.0, qreal(geo.target.height()) / geo.source.height()) * decodeScale;
+            const QSize out(qRound(sourceSize.width() * sx), qRound(sourceSize.height() * sy));
+            if (out != sourceSize)
+                filters.append(QString("scale_vaapi=w=%0:h=%1").arg(qMax(out.width() & ~1, 2)).arg(qMax(out.height() & ~1, 2)));
+        }
+
+        // the aspect ratio of canvas in stretch mode, the frame is not scaled to it.
+        if (scaleMode == kScaleStretch && spanning)
+            aspect = (width() / span.width()) / (height() / span.height());
+
+        // zoomed in to cover the widget, the center part is visible.
+        if (scaleMode == kScaleFill && !spanning) {
+            const qreal fit = qMin(qreal(width()) / sourceSize.width(), qreal(height()) / sourceSize.height());
+            const qreal cover = qMax(qreal(width()) / sourceSize.width(), qreal(height()) / sourceSize.height());
+            zoom = fit > 0 ? std::log2(cover / fit) : 0;
+        }
+    }
+
+    // the frame is the whole canvas when spanning, it is zoomed to the canvas
+    // and panned to the part of this screen.
+    if (spanning) {
+        const QSizeF canvas(width() / span.width(), height() / span.height());
+        // the displayed frame has the shape of canvas unless it is cropped by vo.
+        qreal ratio = canvas.width() / canvas.height();
+        if (gpu && scaleMode != kScaleStretch && sourceSize.isValid())
+            ratio = qreal(sourceSize.width()) / sourceSize.height();
+        const qreal shownWidth = qMax(canvas.width(), canvas.height() * ratio);
+        const QSizeF shown(shownWidth, shownWidth / ratio);
+        const qreal fitted = qMin(qreal(width()), height() * ratio);
+        zoom = fitted > 0 ? std::log2(shown.width() / fitted) : 0;
+        // in the unit of the displayed frame.
+        pan = QPointF((0.5 - span.center().x()) * canvas.width() / shown.width(),
+                      (0.5 - span.center().y()) * canvas.height() / shown.height());
+    }
+
+    QString vf = filters.isEmpty() ? QString() : QString("lavfi=[%0]").arg(filters.join(','));
+    const QString applied = QString("%0|%1|%2|%3|%4|%5").arg(vf).arg(scaleMode).arg(zoom).arg(pan.x()).arg(pan.y()).arg(aspect);
+    if (applied == videoFilters)
+        return;
+
+    // the frames in ring are not filtered by the new filters.
+    videoFilters = applied;
+    stopRing();
+    for (dmr::PlayerWidget *wid : { player, standby }) {
+        if (!wid)
+            continue;
+
+        dmr::PlayerEngine &eng = wid->engine();
+        eng.setBackendProperty("vf", vf);
+        // the cropped frame has the aspect ratio of widget in fill mode.
+        eng.setBackendProperty("keepaspect", spanning || scaleMode != kScaleStretch);
+        eng.setBackendProperty("video-unscaled", !spanning && scaleMode == kScaleCenter ? "yes" : "no");
+        eng.setBackendProperty("video-aspect-override", aspect);
+        eng.setBackendProperty("video-zoom", zoom);
+        eng.setBackendProperty("video-pan-x", pan.x());
+        eng.setBackendProperty("video-pan-y", pan.y());
+    }
+    fmDebug() << "video filters" << vf << "hwdec" << hwdec << "zoom" << zoom;
+}
+
+bool VideoProxy::framesInGpu() const
+{
+    // the copying hwdec downloads the frames by itself.
+    return !hwdec.isEmpty() && hwdec != "no" && !hwdec.endsWith("-copy");
+}
+
+void VideoProxy::updateSourceSize()
+{
+    if (!player)
+        return;
+
+    dmr::PlayerEngine &eng = player->engine();
+    const QSize size(eng.getBackendProperty("width").toInt(), eng.getBackendProperty("height").toInt());
+    const QString hd = eng.getBackendProperty("hwdec-current").toString();
+    if (size == sourceSize && hd == hwdec)
+        return;
+
+    sourceSize = size;
+    hwdec = hd;
+    updateFilters();
+}
+
+void VideoProxy::setPreroll(bool enable)
+{
+    if (preroll == enable)
+        return;
+
+    preroll = enable;
+    prepareStandby();
+}
+
+qint64 VideoProxy::releaseCaches()
+{
+    const qint64 bytes = ringBytes();
+    if (bytes > 0)
+        stopRing();
+
+    if (standby) {
+        delete standby;
+        standby = nullptr;
+        standbyUrl.clear();
+    }
+    return bytes;
+}
+
+qint64 VideoProxy::ringBytes() const
+{
+    return ring ? ring->bytes() : 0;
+}
+
+void VideoProxy::setProbeCache(DecoderProbeCache *cache)
+{
+    probeCache = cache;
+}
+
+void VideoProxy::applyDecodePath(dmr::PlayerWidget *wid, const QUrl &url)
+{
+    const DecodePath dp = probeCache && url.isLocalFile() ? probeCache->lookup(url.toLocalFile()) : DecodePath();
+    dmr::PlayerEngine &eng = wid->engine();
+    // skip the negotiation, mpv still falls back to software if the recorded one fails.
+    if (dp.isValid()) {
+        eng.setBackendProperty("dmrhwdec-switch", false);
+        eng.setBackendProperty("hwdec", dp.hwdec);
+    } else {
+        eng.setBackendProperty("dmrhwdec-switch", true);
+    }
+}
+
+void VideoProxy::beginProbe(const QUrl &url, bool opened)
+{
+    if (!probeCache || !url.isLocalFile())
+        return;
+
+    probing = url;
+    probeOpened = opened;
+    probeTimer.start();
+}
+
+void VideoProxy::finishProbe(const QUrl &url, qint64 startup)
+{
+    if (!probeCache || !player || current != url || player->isHidden()
+            || player->engine().state() != dmr::PlayerEngine::Playing)
+        return;
+
+    dmr::PlayerEngine &eng = player->engine();
+    const QString hd = eng.getBackendProperty("hwdec-current").toString();
+    const qint64 decoded = eng.getBackendProperty("estimated-frame-number").toLongLong();
+    const qint64 dropped = eng.getBackendProperty("frame-drop-count").toLongLong()
+            + eng.getBackendProperty("decoder-frame-drop-count").toLongLong();
+
+    DecodePath dp;
+    dp.hwdec = hd.isEmpty() ? QString("no") : hd;
+    dp.startup = startup;
+    dp.dropRate = decoded > 0 ? qreal(dropped) / decoded : 0;
+    probeCache->record(url.toLocalFile(), dp);
+}
+
+void VideoProxy::negotiateSize(const QSize &size)
+{
+    outputSize = size;
+    updateFilters();
+}
+
+void VideoProxy::setScaleMode(ScaleMode mode)
+{
+    if (scaleMode == mode)
+        return;
 
-    pa.drawImage(x, y, image);
+    scaleMode = mode;
+    updateFilters();
 }
 
 #endif
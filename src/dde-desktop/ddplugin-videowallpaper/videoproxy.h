@@ -6,54 +6,173 @@
 #define VIDEOPROXY_H
 
 #include "ddplugin_videowallpaper_global.h"
+#include "perfcounters.h"
+#include "scalemode.h"
+
+#include <QWidget>
+#include <QImage>
 
 #ifdef USE_LIBDMR
+#include "gapmeter.h"
+#include "framering.h"
+#include "decoderprobecache.h"
+
 #include <player_widget.h>
 #include <player_engine.h>
 #include <compositing_manager.h>
-#else
-#include <QWidget>
-#include <QtMultimedia/QMediaContent>
 
-class QMediaPlayer;
-class QVideoWidget;
-class QMediaPlaylist;
+#include <QPointer>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QFutureWatcher>
 #endif
 
 namespace ddplugin_videowallpaper {
 
-#ifdef USE_LIBDMR
-class VideoProxy : public dmr::PlayerWidget
+class VideoProxy : public QWidget
 {
     Q_OBJECT
 public:
     explicit VideoProxy(QWidget *parent = nullptr);
     ~VideoProxy();
+    // img is scaled to frameSize().
+    void updateImage(const QImage &img);
+    QSize frameSize() const;
+    // the counters of the screen showing this widget.
+    StageCounters *counters();
+    // a frame is ready to be shown.
+    bool hasFrame() const;
+    // the decoder is kept paused with its buffers trimmed, the widget is
+    // shown again after a new frame.
+    void setSuspended(bool suspended);
+    qint64 imageBytes() const;
+    // the part of frame shown by this widget when the video spans the screens,
+    // normalized to 0~1. it is null if the video is not spanned.
+    void setSpanRegion(const QRectF &region);
+    QRectF spanRegion() const;
+#ifdef USE_LIBDMR
     void setPlayList(const QList<QUrl> &list);
     void play();
     void stop();
+    // a widget with source only paints the frames decoded by the source.
+    void setSource(VideoProxy *src);
+    VideoProxy *source() const;
+    bool isDecoding() const;
+    void setMirrored(bool mirrored);
+    void setMaxFps(int fps);
+    void setDecodeScale(qreal scale);
+    void setScaleMode(ScaleMode mode);
+    // the decoder outputs frames for the pixel size, or for the widget if it is invalid.
+    void negotiateSize(const QSize &size);
+    // keep the position and the last frame while paused.
+    void setPaused(bool paused);
+    const GapMeter &transitionGap() const;
+    // the states sampled from mpv.
+    QVariantMap decoderStats() const;
+    // the single short clip is decoded once and looped from memory.
+    void setFrameCache(bool enable, qint64 maxLength, qint64 budget);
+    // the decode path of a probed stream is used directly.
+    void setProbeCache(DecoderProbeCache *cache);
+    // the next item is not pre-rolled if disabled.
+    void setPreroll(bool enable);
+    // drops the frame ring and the pre-rolled item, returns the bytes of ring.
+    qint64 releaseCaches();
+    qint64 ringBytes() const;
+    // for keeping in step with other decoders.
+    int currentIndex() const;
+    void playIndex(int index);
+    qint64 position() const;   // ms, -1 if unknown
+    qreal frameInterval() const;   // ms
+    void setSpeed(qreal speed);
+    void seekTo(qint64 ms);
+#endif
+signals:
+    void frameShown();   // emitted when the first frame is ready
+#ifdef USE_LIBDMR
+    void frameReady(const QImage &img);
+    void itemChanged(int index);
 protected slots:
     void playNext();
+    void tapFrame();
+    void finishTap();
+    void playRingFrame(const QImage &img);
+    void stopRing();
+#endif
+protected:
+    void paintEvent(QPaintEvent *) override;
+    void resizeEvent(QResizeEvent *) override;
+    QRect imageRect() const;
+    void paintImage(const QRegion &region);
+    void setFrameReady();
 private:
+#ifdef USE_LIBDMR
+    dmr::PlayerWidget *newPlayer();
+    void createPlayer();
+    void destroyPlayer();
+    int nextIndex() const;
+    void updateLoop();
+    void prepareStandby();
+    void updateFilters();
+    bool framesInGpu() const;
+    void updateSourceSize();
+    void updateTap();
+    void updateRing();
+    void recordFrame(const QImage &img, qint64 pts);
+    void updateTapInterval();
+    void waitTap();
+    void switchTo(const QUrl &next);
+    void applyDecodePath(dmr::PlayerWidget *wid, const QUrl &url);
+    void beginProbe(const QUrl &url, bool opened);
+    void finishProbe(const QUrl &url, qint64 startup);
+    dmr::PlayerWidget *player = nullptr;
+    dmr::PlayerWidget *standby = nullptr;   // the next item is pre-rolled in it
+    QUrl standbyUrl;
+    QPointer<VideoProxy> decoder;
+    QTimer tapTimer;
+    struct TapResult
+    {
+        QImage frame;
+        QImage ringFrame;   // scaled for the screen if recording
+        qint64 pts = -1;   // ms
+        qint64 number = -1;   // the frame number of decoder
+    };
+    QThreadPool tapPool;   // one readback at a time
+    QFutureWatcher<TapResult> *tapping = nullptr;
+    qint64 lastTapped = -1;
     QList<QUrl> playList;
     QUrl current;
+    int position = 0;   // index of the replaced current
     bool run = false;
-};
-
-#else
-class VideoProxy : public QWidget
-{
-    Q_OBJECT
-public:
-    explicit VideoProxy(QWidget *parent = nullptr);
-    ~VideoProxy();
-    void updateImage(const QImage &img);
-protected:
-    void paintEvent(QPaintEvent *) override;
-private:
+    bool paused = false;
+    int maxFps = 0;
+    qreal decodeScale = 1.0;
+    ScaleMode scaleMode = kScaleFit;
+    QSize sourceSize;
+    QString hwdec;   // the hwdec in use, empty or "no" if decoded by software
+    QSize outputSize;
+    QString videoFilters;   // the filters and mode applied to players
+    GapMeter gap;
+    bool mirrored = false;
+    FrameRing *ring = nullptr;
+    qint64 ringMaxLength = 0;   // ms
+    qint64 lastPts = -1;
+    QUrl ringRejected;   // the clip can not be kept in ring
+    DecoderProbeCache *probeCache = nullptr;
+    QUrl probing;   // the item waiting for its first frame
+    bool probeOpened = false;   // the item is opened by player, not pre-rolled
+    bool preroll = true;
+    qreal playSpeed = 1.0;
+    QElapsedTimer probeTimer;
+#endif
     QImage image;
+    QRect videoRect;   // where the image is painted
+    QRectF span;
+    bool ready = false;
+    bool suspended = false;
+    StageCounters *perf = nullptr;
 };
-#endif
+
 typedef QSharedPointer<VideoProxy> VideoProxyPointer;
 
 }
@@ -5,22 +5,28 @@
 #ifndef USE_LIBDMR
 
 #include "videosurface.h"
+#include "framebufferpool.h"
+#include "ddplugin_videowallpaper_global.h"
 
 #include <QDebug>
 #include <QTime>
+#include <QtMath>
 
 using namespace ddplugin_videowallpaper;
 
 VideoSurface::VideoSurface(QObject *parent) : QAbstractVideoSurface(parent)
 {
-
+    clock.start();
+    perf = PerfCounters::instance()->stage("decoder");
 }
 
 QList<QVideoFrame::PixelFormat> VideoSurface::supportedPixelFormats(QAbstractVideoBuffer::HandleType type) const
 {
     if (type == QAbstractVideoBuffer::NoHandle) {
+        // the YUV frames are converted by our own kernels.
         return QList<QVideoFrame::PixelFormat> {
-            QVideoFrame::Format_ARGB32,
+            QVideoFrame::Format_YUV420P,
+            QVideoFrame::Format_NV12,
             QVideoFrame::Format_ARGB32,
             QVideoFrame::Format_ARGB32_Premultiplied,
             QVideoFrame::Format_RGB32
@@ -30,16 +36,179 @@ QList<QVideoFrame::PixelFormat> VideoSurface::supportedPixelFormats(QAbstractVid
     return {};
 }
 
+bool VideoSurface::start(const QVideoSurfaceFormat &format)
+{
+    YuvConverter::ColorSpace space = YuvConverter::kBT601;
+    YuvConverter::ColorRange range = YuvConverter::kLimited;
+    switch (format.yCbCrColorSpace()) {
+    case QVideoSurfaceFormat::YCbCr_BT709:
+    case QVideoSurfaceFormat::YCbCr_xvYCC709:
+        space = YuvConverter::kBT709;
+        break;
+    case QVideoSurfaceFormat::YCbCr_JPEG:
+        range = YuvConverter::kFull;
+        break;
+    case QVideoSurfaceFormat::YCbCr_Undefined:
+        // HD videos are usually in BT.709.
+        if (format.frameHeight() >= 720)
+            space = YuvConverter::kBT709;
+        break;
+    default:
+        break;
+    }
+
+    yuv = YuvConverter(space, range);
+    fmInfo() << "video format" << format.pixelFormat() << format.frameSize() << format.yCbCrColorSpace()
+             << "yuv kernel" << YuvConverter::kernelName(yuv.kernel());
+    return QAbstractVideoSurface::start(format);
+}
+
 bool VideoSurface::present(const QVideoFrame &frame)
 {
-    QVideoFrame clone(frame);
-    if (!clone.map(QAbstractVideoBuffer::ReadOnly))
+    const qint64 begin = clock.nsecsElapsed();
+    perf->decoded.fetchAndAddRelaxed(1);
+
+    // the frame comes later than one and a half intervals.
+    const qreal rate = surfaceFormat().frameRate();
+    if (rate > 0 && lastFrame >= 0 && begin - lastFrame > 1.5e9 / rate)
+        perf->late.fetchAndAddRelaxed(1);
+    lastFrame = begin;
+
+    // drop the frames beyond the limit before mapping them.
+    if (!limiter.accept(begin / 1000)) {
+        perf->dropped.fetchAndAddRelaxed(1);
+        return true;
+    }
+
+    QImage img;
+    if (frame.pixelFormat() == QVideoFrame::Format_YUV420P || frame.pixelFormat() == QVideoFrame::Format_NV12) {
+        img = convertYuv(frame);
+    } else {
+        // the image shares the mapped frame, it is released after all widgets consumed it.
+        img = FrameBufferPool::instance()->wrap(frame);
+        pushedRegion = QRectF(0, 0, 1, 1);
+    }
+
+    if (img.isNull())
         return false;
 
-    QImage img = QImage(clone.bits(), clone.width(), clone.height(), QVideoFrame::imageFormatFromPixelFormat(clone.pixelFormat())).copy();
-    clone.unmap();
+    // the bytes allocated or copied by pool for this frame.
+    FrameBufferPool::instance()->countFrame();
+    auto stat = FrameBufferPool::instance()->counters();
+    const quint64 bytes = stat.allocatedBytes + stat.copiedBytes;
+    perf->allocatedBytes.fetchAndAddRelaxed(bytes - poolBytes);
+    poolBytes = bytes;
+    perf->present.add(clock.nsecsElapsed() - begin);
+
     emit pushImage(img);
+
+    if (++presented % 1000 == 0) {
+        fmDebug() << "frames" << stat.frames << "shared" << stat.shared << "copied" << stat.copied
+                  << "copied bytes" << stat.copiedBytes << "buffers allocated" << stat.allocations;
+    }
     return true;
 }
-#endif
+void VideoSurface::setMaxFps(int fps)
+{
+    limiter.setMaxFps(fps);
+}
+
+void VideoSurface::setDecodeScale(qreal scale)
+{
+    decodeScale = qBound(0.1, scale, 1.0);
+}
 
+void VideoSurface::setSourceRegion(const QRectF &region)
+{
+    sourceRegion = region.intersected(QRectF(0, 0, 1, 1));
+    if (sourceRegion.isEmpty())
+        sourceRegion = QRectF(0, 0, 1, 1);
+}
+
+QRectF VideoSurface::frameRegion() const
+{
+    return pushedRegion;
+}
+
+void VideoSurface::setTargetSize(const QSize &size)
+{
+    target = size;
+}
+
+QSize VideoSurface::targetSize() const
+{
+    return target;
+}
+
+QImage VideoSurface::convertYuv(const QVideoFrame &frame)
+{
+    QVideoFrame clone(frame);
+    if (!clone.map(QAbstractVideoBuffer::ReadOnly))
+        return QImage();
+
+    YuvFrame src;
+    src.layout = clone.pixelFormat() == QVideoFrame::Format_NV12 ? YuvFrame::kNV12 : YuvFrame::kI420;
+    src.width = clone.width();
+    src.height = clone.height();
+    if (clone.planeCount() > 1) {
+        src.y = clone.bits(0);
+        src.yStride = clone.bytesPerLine(0);
+        src.u = clone.bits(1);
+        src.uStride = clone.bytesPerLine(1);
+        if (clone.planeCount() > 2) {
+            src.v = clone.bits(2);
+            src.vStride = clone.bytesPerLine(2);
+        }
+    } else {
+        // planes are contiguous.
+        src.y = clone.bits();
+        src.yStride = clone.bytesPerLine();
+        src.u = src.y + src.yStride * src.height;
+        if (src.layout == YuvFrame::kNV12) {
+            src.uStride = src.yStride;
+        } else {
+            src.uStride = src.yStride / 2;
+            src.v = src.u + src.uStride * ((src.height + 1) / 2);
+            src.vStride = src.uStride;
+        }
+    }
+
+    // skip the invisible part, the crop is aligned to chroma samples.
+    QRect crop(QPoint(0, 0), clone.size());
+    if (sourceRegion != QRectF(0, 0, 1, 1)) {
+        const int x = qRound(sourceRegion.x() * src.width) & ~1;
+        const int y = qRound(sourceRegion.y() * src.height) & ~1;
+        const int w = qMin(qRound(sourceRegion.width() * src.width + 1) & ~1, src.width - x);
+        const int h = qMin(qRound(sourceRegion.height() * src.height + 1) & ~1, src.height - y);
+        if (w >= 2 && h >= 2) {
+            crop = QRect(x, y, w, h);
+            src.y += y * src.yStride + x;
+            src.u += (y / 2) * src.uStride + (src.layout == YuvFrame::kNV12 ? x : x / 2);
+            if (src.v)
+                src.v += (y / 2) * src.vStride + x / 2;
+            src.width = w;
+            src.height = h;
+        }
+    }
+
+    pushedRegion = QRectF(qreal(crop.x()) / clone.width(), qreal(crop.y()) / clone.height(),
+                          qreal(crop.width()) / clone.width(), qreal(crop.height()) / clone.height());
+
+    // downscaled to the screens in the same pass of converting.
+    QSize size = crop.size();
+    if (target.isValid() && (target.width() < clone.width() || target.height() < clone.height())) {
+        size = QSize(qMax(qCeil(qreal(size.width()) * qMin(target.width(), clone.width()) / clone.width()), 2),
+                     qMax(qCeil(qreal(size.height()) * qMin(target.height(), clone.height()) / clone.height()), 2));
+    }
+
+    if (decodeScale < 1.0)
+        size = QSize(qMax(qRound(size.width() * decodeScale), 2), qMax(qRound(size.height() * decodeScale), 2));
+
+    QImage img = FrameBufferPool::instance()->allocate(size, QImage::Format_RGB32);
+    if (!img.isNull() && !yuv.convert(src, img.bits(), img.bytesPerLine(), img.width(), img.height()))
+        img = QImage();
+
+    clone.unmap();
+    return img;
+}
+#endif
@@ -6,7 +6,13 @@
 #define VIDEOSURFACE_H
 
 #ifndef USE_LIBDMR
+#include "yuvconverter.h"
+#include "framelimiter.h"
+#include "perfcounters.h"
+
 #include <QAbstractVideoSurface>
+#include <QVideoSurfaceFormat>
+#include <QElapsedTimer>
 
 namespace ddplugin_videowallpaper {
 
@@ -17,11 +23,34 @@ public:
     explicit VideoSurface(QObject *parent = nullptr);
     QList<QVideoFrame::PixelFormat> supportedPixelFormats(
             QAbstractVideoBuffer::HandleType type = QAbstractVideoBuffer::NoHandle) const override;
+    bool start(const QVideoSurfaceFormat &format) override;
     bool present(const QVideoFrame &frame) override;
+    void setMaxFps(int fps);
+    // scale the YUV frames while converting them.
+    void setDecodeScale(qreal scale);
+    // only the region of YUV frames is converted, it is normalized to 0~1.
+    void setSourceRegion(const QRectF &region);
+    // the region of frame in the image just pushed.
+    QRectF frameRegion() const;
+    // the size that the whole frame is converted to, the frames are never scaled up.
+    void setTargetSize(const QSize &size);
+    QSize targetSize() const;
 signals:
     void pushImage(const QImage &img);
 protected:
-
+    QImage convertYuv(const QVideoFrame &frame);
+protected:
+    YuvConverter yuv;
+    FrameLimiter limiter;
+    QElapsedTimer clock;
+    qreal decodeScale = 1.0;
+    QRectF sourceRegion = QRectF(0, 0, 1, 1);
+    QRectF pushedRegion = QRectF(0, 0, 1, 1);
+    QSize target;
+    quint64 presented = 0;
+    StageCounters *perf = nullptr;
+    qint64 lastFrame = -1;   // ns
+    quint64 poolBytes = 0;
 };
 
 }
@@ -4,6 +4,7 @@
 
 #include "videowallpaperplugin.h"
 #include "wallpaperengine.h"
+#include "perfcounters.h"
 
 #include <QTranslator>
 
@@ -34,6 +35,7 @@ void ddplugin_videowallpaper::VideoWallpaperPlugin::initialize()
 
 bool VideoWallpaperPlugin::start()
 {
+    PerfCounters::instance()->mark("pluginStart");
     engine = new WallpaperEngine();
     return engine->init();
 }
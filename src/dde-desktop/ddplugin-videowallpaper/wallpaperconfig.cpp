@@ -21,6 +21,15 @@ Q_GLOBAL_STATIC(WallpaperConfigGlobal, wallpaperConfig)
 
 static constexpr char kConfName[] = "org.deepin.dde.file-manager.desktop.videowallpaper";
 static constexpr char kKeyEnable[] = "enable";
+static constexpr char kKeyMaxFps[] = "maxFps";
+static constexpr char kKeyPowerPolicy[] = "powerPolicy";
+static constexpr char kKeyTranscodeCache[] = "transcodeCache";
+static constexpr char kKeyFrameCache[] = "frameCache";
+static constexpr char kKeyScaleMode[] = "scaleMode";
+static constexpr char kKeyStandbyTimeout[] = "standbyTimeout";
+static constexpr char kKeyMemoryLimit[] = "memoryLimit";
+static constexpr char kKeySpanScreens[] = "spanScreens";
+static constexpr char kKeyScreenSources[] = "screenSources";
 
 WallpaperConfigPrivate::WallpaperConfigPrivate(WallpaperConfig *qq)
     : q(qq)
@@ -36,6 +45,106 @@ bool WallpaperConfigPrivate::getEnable() const
     return ret;
 }
 
+int WallpaperConfigPrivate::getMaxFps() const
+{
+    int ret = 0;
+    if (settings)
+        ret = settings->value(kKeyMaxFps, 0).toInt();
+    // 0 means no limit.
+    return qMax(ret, 0);
+}
+
+bool WallpaperConfigPrivate::getTranscodeCache() const
+{
+    bool ret = false;
+    if (settings)
+        ret = settings->value(kKeyTranscodeCache, false).toBool();
+    return ret;
+}
+
+ScaleMode WallpaperConfigPrivate::getScaleMode() const
+{
+    QString ret;
+    if (settings)
+        ret = settings->value(kKeyScaleMode, "fit").toString();
+    // fit, fill, stretch or center.
+    return ScaleGeometry::modeFromString(ret);
+}
+
+bool WallpaperConfigPrivate::getSpanScreens() const
+{
+    bool ret = false;
+    if (settings)
+        ret = settings->value(kKeySpanScreens, false).toBool();
+    return ret;
+}
+
+QMap<QString, QString> WallpaperConfigPrivate::getScreenSources() const
+{
+    QMap<QString, QString> ret;
+    if (!settings)
+        return ret;
+
+    const QVariantMap map = settings->value(kKeyScreenSources).toMap();
+    for (auto itor = map.begin(); itor != map.end(); ++itor) {
+        const QString path = itor.value().toString().trimmed();
+        if (!path.isEmpty())
+            ret.insert(itor.key(), path);
+    }
+    return ret;
+}
+
+PowerThresholds WallpaperConfigPrivate::getPowerThresholds() const
+{
+    PowerThresholds ret;
+    if (!settings)
+        return ret;
+
+    // powerPolicy is a map, the missing items use default value.
+    const QVariantMap map = settings->value(kKeyPowerPolicy).toMap();
+    ret.enable = map.value("enable", ret.enable).toBool();
+    ret.batteryLow = map.value("batteryLow", ret.batteryLow).toInt();
+    ret.batteryCritical = map.value("batteryCritical", ret.batteryCritical).toInt();
+    ret.thermalWarm = map.value("thermalWarm", ret.thermalWarm).toInt();
+    ret.thermalHot = map.value("thermalHot", ret.thermalHot).toInt();
+    ret.thermalCritical = map.value("thermalCritical", ret.thermalCritical).toInt();
+    ret.reducedFps = qMax(map.value("reducedFps", ret.reducedFps).toInt(), 1);
+    ret.reducedScale = qBound(0.1, map.value("reducedScale", ret.reducedScale).toDouble(), 1.0);
+    ret.batteryMargin = qMax(map.value("batteryMargin", ret.batteryMargin).toInt(), 0);
+    ret.thermalMargin = qMax(map.value("thermalMargin", ret.thermalMargin).toInt(), 0);
+    ret.holdTime = qMax(map.value("holdTime", ret.holdTime).toInt(), 0);
+    return ret;
+}
+
+FrameCacheConfig WallpaperConfigPrivate::getFrameCache() const
+{
+    FrameCacheConfig ret;
+    if (!settings)
+        return ret;
+
+    const QVariantMap map = settings->value(kKeyFrameCache).toMap();
+    ret.enable = map.value("enable", ret.enable).toBool();
+    ret.maxLength = qMax(map.value("maxLength", ret.maxLength).toInt(), 1);
+    ret.budget = qMax(map.value("budget", ret.budget).toInt(), 0);
+    return ret;
+}
+
+int WallpaperConfigPrivate::getStandbyTimeout() const
+{
+    int ret = 120;
+    if (settings)
+        ret = settings->value(kKeyStandbyTimeout, ret).toInt();
+    return qMax(ret, 0);
+}
+
+int WallpaperConfigPrivate::getMemoryLimit() const
+{
+    int ret = 0;
+    if (settings)
+        ret = settings->value(kKeyMemoryLimit, ret).toInt();
+    return qMax(ret, 0);
+}
+
 WallpaperConfig *WallpaperConfig::instance()
 {
     return wallpaperConfig;
@@ -46,6 +155,51 @@ bool WallpaperConfig::enable() const
     return d->enable;
 }
 
+int WallpaperConfig::maxFps() const
+{
+    return d->maxFps;
+}
+
+bool WallpaperConfig::transcodeCache() const
+{
+    return d->transcodeCache;
+}
+
+PowerThresholds WallpaperConfig::powerThresholds() const
+{
+    return d->powerThresholds;
+}
+
+ScaleMode WallpaperConfig::scaleMode() const
+{
+    return d->scaleMode;
+}
+
+int WallpaperConfig::standbyTimeout() const
+{
+    return d->standbyTimeout;
+}
+
+int WallpaperConfig::memoryLimit() const
+{
+    return d->memoryLimit;
+}
+
+bool WallpaperConfig::spanScreens() const
+{
+    return d->spanScreens;
+}
+
+QMap<QString, QString> WallpaperConfig::screenSources() const
+{
+    return d->screenSources;
+}
+
+FrameCacheConfig WallpaperConfig::frameCache() const
+{
+    return d->frameCache;
+}
+
 void WallpaperConfig::setEnable(bool e)
 {
     if (d->enable == e)
@@ -71,6 +225,15 @@ WallpaperConfig::WallpaperConfig(QObject *parent)
 void WallpaperConfig::initialize()
 {
     d->enable = d->getEnable();
+    d->maxFps = d->getMaxFps();
+    d->transcodeCache = d->getTranscodeCache();
+    d->scaleMode = d->getScaleMode();
+    d->spanScreens = d->getSpanScreens();
+    d->screenSources = d->getScreenSources();
+    d->powerThresholds = d->getPowerThresholds();
+    d->frameCache = d->getFrameCache();
+    d->standbyTimeout = d->getStandbyTimeout();
+    d->memoryLimit = d->getMemoryLimit();
     if (d->settings)
         connect(d->settings, &DConfig::valueChanged,
                 this, &WallpaperConfig::configChanged, Qt::UniqueConnection);
@@ -83,5 +246,56 @@ void WallpaperConfig::configChanged(const QString &key)
         bool e = d->getEnable();
         if (e != d->enable)
             emit changeEnableState(e);
+    } else if (key == kKeyMaxFps) {
+        int fps = d->getMaxFps();
+        if (fps != d->maxFps) {
+            d->maxFps = fps;
+            emit changeMaxFps(fps);
+        }
+    } else if (key == kKeyPowerPolicy) {
+        PowerThresholds thr = d->getPowerThresholds();
+        if (thr != d->powerThresholds) {
+            d->powerThresholds = thr;
+            emit changePowerPolicy();
+        }
+    } else if (key == kKeyTranscodeCache) {
+        bool e = d->getTranscodeCache();
+        if (e != d->transcodeCache) {
+            d->transcodeCache = e;
+            emit changeTranscodeCache(e);
+        }
+    } else if (key == kKeyFrameCache) {
+        FrameCacheConfig cfg = d->getFrameCache();
+        if (cfg != d->frameCache) {
+            d->frameCache = cfg;
+            emit changeFrameCache();
+        }
+    } else if (key == kKeyStandbyTimeout) {
+        // read when turning off, no one needs to be notified.
+        d->standbyTimeout = d->getStandbyTimeout();
+    } else if (key == kKeyMemoryLimit) {
+        int limit = d->getMemoryLimit();
+        if (limit != d->memoryLimit) {
+            d->memoryLimit = limit;
+            emit changeMemoryLimit();
+        }
+    } else if (key == kKeySpanScreens) {
+        bool e = d->getSpanScreens();
+        if (e != d->spanScreens) {
+            d->spanScreens = e;
+            emit changeSpanScreens();
+        }
+    } else if (key == kKeyScreenSources) {
+        auto sources = d->getScreenSources();
+        if (sources != d->screenSources) {
+            d->screenSources = sources;
+            emit changeScreenSources();
+        }
+    } else if (key == kKeyScaleMode) {
+        ScaleMode mode = d->getScaleMode();
+        if (mode != d->scaleMode) {
+            d->scaleMode = mode;
+            emit changeScaleMode(mode);
+        }
     }
 }
@@ -5,10 +5,55 @@
 #ifndef WALLPAPERCONFIG_H
 #define WALLPAPERCONFIG_H
 
+#include "scalemode.h"
+
 #include <QObject>
+#include <QMap>
 
 namespace ddplugin_videowallpaper {
 
+struct PowerThresholds
+{
+    bool enable = true;
+    int batteryLow = 30;   // percent
+    int batteryCritical = 15;
+    int thermalWarm = 75;   // celsius
+    int thermalHot = 85;
+    int thermalCritical = 95;
+    int reducedFps = 15;
+    qreal reducedScale = 0.5;   // decode resolution
+    int batteryMargin = 5;   // hysteresis
+    int thermalMargin = 5;
+    int holdTime = 30;   // seconds
+    inline bool operator==(const PowerThresholds &other) const
+    {
+        return enable == other.enable && batteryLow == other.batteryLow && batteryCritical == other.batteryCritical
+                && thermalWarm == other.thermalWarm && thermalHot == other.thermalHot
+                && thermalCritical == other.thermalCritical && reducedFps == other.reducedFps
+                && qFuzzyCompare(reducedScale, other.reducedScale) && batteryMargin == other.batteryMargin
+                && thermalMargin == other.thermalMargin && holdTime == other.holdTime;
+    }
+    inline bool operator!=(const PowerThresholds &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+struct FrameCacheConfig
+{
+    bool enable = false;
+    int maxLength = 20;   // seconds, the longer clips are not cached
+    int budget = 256;   // MiB of compressed frames, the cache is evicted beyond it
+    inline bool operator==(const FrameCacheConfig &other) const
+    {
+        return enable == other.enable && maxLength == other.maxLength && budget == other.budget;
+    }
+    inline bool operator!=(const FrameCacheConfig &other) const
+    {
+        return !(*this == other);
+    }
+};
+
 class WallpaperConfigPrivate;
 class WallpaperConfig : public QObject
 {
@@ -19,8 +64,29 @@ public:
     void initialize();
     bool enable() const;
     void setEnable(bool);
+    int maxFps() const;
+    bool transcodeCache() const;
+    FrameCacheConfig frameCache() const;
+    ScaleMode scaleMode() const;
+    // seconds to keep the suspended players after turning off, 0 to release them at once.
+    int standbyTimeout() const;
+    // MiB of the resident size of desktop, 0 for no limit.
+    int memoryLimit() const;
+    // one video spans the screens instead of playing on each of them.
+    bool spanScreens() const;
+    // screen name -- the video directory or playlist file of it, the others play the default directory.
+    QMap<QString, QString> screenSources() const;
+    PowerThresholds powerThresholds() const;
 signals:
     void changeEnableState(bool enable);
+    void changeMaxFps(int fps);
+    void changePowerPolicy();
+    void changeTranscodeCache(bool enable);
+    void changeFrameCache();
+    void changeScaleMode(int mode);
+    void changeMemoryLimit();
+    void changeSpanScreens();
+    void changeScreenSources();
     void checkResource();
 public slots:
 private slots:
@@ -16,7 +16,25 @@ class WallpaperConfigPrivate
 public:
     WallpaperConfigPrivate(WallpaperConfig *qq);
     bool getEnable() const;
+    int getMaxFps() const;
+    bool getTranscodeCache() const;
+    ScaleMode getScaleMode() const;
+    bool getSpanScreens() const;
+    QMap<QString, QString> getScreenSources() const;
+    PowerThresholds getPowerThresholds() const;
+    FrameCacheConfig getFrameCache() const;
+    int getStandbyTimeout() const;
+    int getMemoryLimit() const;
     bool enable = false;
+    int maxFps = 0;
+    bool transcodeCache = false;
+    ScaleMode scaleMode = kScaleFit;
+    bool spanScreens = false;
+    QMap<QString, QString> screenSources;
+    PowerThresholds powerThresholds;
+    FrameCacheConfig frameCache;
+    int standbyTimeout = 120;
+    int memoryLimit = 0;
     DTK_CORE_NAMESPACE::DConfig *settings = nullptr;
 private:
     WallpaperConfig *q;
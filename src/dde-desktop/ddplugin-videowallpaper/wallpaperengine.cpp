@@ -12,18 +12,32 @@
 #include "dfm-base/dfm_desktop_defines.h"
 
 #ifndef USE_LIBDMR
+#include "framebufferpool.h"
+
 #include <QtMultimedia/QMediaContent>
 #endif
 
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
 #include <QStandardPaths>
 #include <QDBusInterface>
 #include <QDBusPendingReply>
 #include <QDebug>
+#include <QTimer>
+#include <QtMath>
 
 using namespace ddplugin_videowallpaper;
 DFMBASE_USE_NAMESPACE
 
+// the frames of idle screens are dropped after this time.
+static constexpr int kTrimDelay = 10000;   // ms
+
+#ifndef USE_LIBDMR
+// the recording starts at the beginning of a loop.
+static constexpr int kRingStartWindow = 100;   // ms
+#endif
+
 #define CanvasCoreSubscribe(topic, func) \
     dpfSignalDispatcher->subscribe("ddplugin_core", QT_STRINGIFY2(topic), this, func);
 
@@ -50,6 +64,49 @@ static QMap<QString, QWidget *> rootMap()
     return ret;
 }
 
+// rect in outer, normalized to 0~1.
+static QRectF normalizedIn(const QRect &rect, const QRect &outer)
+{
+    if (outer.isEmpty())
+        return QRectF();
+
+    return QRectF(qreal(rect.x() - outer.x()) / outer.width(), qreal(rect.y() - outer.y()) / outer.height(),
+                  qreal(rect.width()) / outer.width(), qreal(rect.height()) / outer.height());
+}
+
+// the same media is resolved to the same path.
+static QString resolvePath(QString path)
+{
+    if (path.startsWith("~/"))
+        path = QDir::homePath() + path.mid(1);
+
+    const QFileInfo info(path);
+    const QString ret = info.canonicalFilePath();
+    return ret.isEmpty() ? info.absoluteFilePath() : ret;
+}
+
+// a playlist lists a video in each line, the relative paths are in the directory of it.
+static QStringList readPlaylist(const QString &file)
+{
+    QStringList ret;
+    QFile f(file);
+    if (!f.open(QFile::ReadOnly | QFile::Text))
+        return ret;
+
+    const QDir dir = QFileInfo(file).absoluteDir();
+    while (!f.atEnd()) {
+        const QString line = QString::fromUtf8(f.readLine()).trimmed();
+        // the comments and the extended tags of m3u.
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+
+        const QUrl url(line);
+        const QString path = QFileInfo(dir, url.isLocalFile() ? url.toLocalFile() : line).canonicalFilePath();
+        if (!path.isEmpty())
+            ret.append(path);
+    }
+    return ret;
+}
 
 WallpaperEnginePrivate::WallpaperEnginePrivate(WallpaperEngine *qq)
     : q(qq)
@@ -57,22 +114,38 @@ WallpaperEnginePrivate::WallpaperEnginePrivate(WallpaperEngine *qq)
 
 }
 
+QList<QUrl> WallpaperEnginePrivate::sourceVideos(const QString &source) const
+{
+    QList<QUrl> ret;
+    if (!index)
+        return ret;
+
+    if (!QFileInfo(source).isFile())
+        return index->videos(source);
+
+    // in the order of playlist, the files not probed as video are skipped.
+    const MediaInfoMap entries = index->entries();
+    for (const QString &file : readPlaylist(source)) {
+        if (entries.value(file).playable)
+            ret.append(QUrl::fromLocalFile(file));
+    }
+    return ret;
+}
+
 #ifdef USE_LIBDMR
-QList<QUrl> WallpaperEnginePrivate::getVideos(const QString &path)
+QList<QUrl> WallpaperEnginePrivate::getVideos(const QString &source) const
 {
     QList<QUrl> ret;
-    QDir dir(path);
-    for (const QFileInfo &file : dir.entryInfoList(QDir::Files))
-        ret << QUrl::fromLocalFile(file.absoluteFilePath());
+    for (const QUrl &url : sourceVideos(source))
+        ret << (cache ? cache->lookup(url, cacheSize) : url);
     return ret;
 }
 #else
-QList<QMediaContent> WallpaperEnginePrivate::getVideos(const QString &path)
+QList<QMediaContent> WallpaperEnginePrivate::getVideos() const
 {
     QList<QMediaContent> ret;
-    QDir dir(path);
-    for (const QFileInfo &file : dir.entryInfoList(QDir::Files))
-        ret << QMediaContent(QUrl::fromLocalFile(file.absoluteFilePath()));
+    for (const QUrl &url : sourceVideos(sourceOf(QString())))
+        ret << QMediaContent(cache ? cache->lookup(url, cacheSize) : url);
 
     return ret;
 }
@@ -90,15 +163,26 @@ VideoProxyPointer WallpaperEnginePrivate::createWidget(QWidget *root)
     bwp->setProperty(DesktopFrameProperty::kPropScreenName, getScreenName(root));
     bwp->setProperty(DesktopFrameProperty::kPropWidgetName, "videowallpaper");
     bwp->setProperty(DesktopFrameProperty::kPropWidgetLevel, 5.1);
+#ifdef USE_LIBDMR
+    bwp->setProbeCache(probes);
+#endif
+    // the background is kept until the first frame.
+    QObject::connect(bwp.get(), &VideoProxy::frameShown, q, [this]() {
+        PerfCounters::instance()->mark("firstFrame");
+        updateVisibility();
+    });
 
     fmDebug() << "screen name" << screenName << "geometry" << root->geometry() << bwp.get();
     return bwp;
 }
 
-void WallpaperEnginePrivate::setBackgroundVisible(bool v)
+void WallpaperEnginePrivate::setBackgroundVisible(bool v, const QString &screen)
 {
     QList<QWidget *> roots = ddplugin_desktop_util::desktopFrameRootWindows();
     for (QWidget *root  : roots) {
+        if (!screen.isEmpty() && getScreenName(root) != screen)
+            continue;
+
         for (QObject *obj : root->children()) {
             if (QWidget *wid = dynamic_cast<QWidget *>(obj)) {
                 QString type = wid->property(DesktopFrameProperty::kPropWidgetName).toString();
@@ -116,11 +200,776 @@ QString WallpaperEnginePrivate::sourcePath() const
     return path;
 }
 
+QString WallpaperEnginePrivate::sourceOf(const QString &screen) const
+{
+#ifdef USE_LIBDMR
+    const QString path = WpCfg->screenSources().value(screen);
+    if (!path.isEmpty())
+        return resolvePath(path);
+#else
+    // all screens share one player.
+    Q_UNUSED(screen)
+#endif
+    return resolvePath(sourcePath());
+}
+
+QStringList WallpaperEnginePrivate::sources() const
+{
+    // only the sources of the shown screens are scanned.
+    QStringList ret { sourceOf(QString()) };
+    for (const QString &screen : widgets.keys())
+        ret.append(sourceOf(screen));
+    ret.removeDuplicates();
+    return ret;
+}
+
+QStringList WallpaperEnginePrivate::sourceDirs() const
+{
+    QStringList ret;
+    for (const QString &source : sources()) {
+        if (!QFileInfo(source).isFile()) {
+            ret.append(source);
+            continue;
+        }
+
+        for (const QString &file : readPlaylist(source))
+            ret.append(QFileInfo(file).absolutePath());
+    }
+    ret.removeDuplicates();
+    return ret;
+}
+
+void WallpaperEnginePrivate::updateSources()
+{
+    if (!watcher || !index)
+        return;
+
+    // the playlist files are watched with the directories of their videos, and they
+    // are added again since the editors may replace them.
+    const QStringList dirs = sourceDirs();
+    QStringList paths = dirs;
+    for (const QString &source : sources()) {
+        if (QFileInfo(source).isFile())
+            paths.append(source);
+    }
+
+    const QStringList watched = watcher->files() + watcher->directories();
+    if (!watched.isEmpty())
+        watcher->removePaths(watched);
+    if (!paths.isEmpty())
+        watcher->addPaths(paths);
+
+    index->scheduleScan(dirs);
+}
+
+void WallpaperEnginePrivate::applyFrameRate()
+{
+    int fps = WpCfg->maxFps();
+    if (power && power->level() >= PowerPolicy::kReducedFps) {
+        const int reduced = WpCfg->powerThresholds().reducedFps;
+        fps = fps > 0 ? qMin(fps, reduced) : reduced;
+    }
+#ifndef USE_LIBDMR
+    if (surface)
+        surface->setMaxFps(fps);
+#else
+    for (const VideoProxyPointer &bwp : widgets.values())
+        bwp->setMaxFps(fps);
+#endif
+}
+
+void WallpaperEnginePrivate::updateScreens()
+{
+    if (!occlusion)
+        return;
+
+    QMap<QString, QRect> screens;
+    auto winMap = rootMap();
+    for (auto itor = winMap.begin(); itor != winMap.end(); ++itor) {
+        if (widgets.contains(itor.key()))
+            screens.insert(itor.key(), itor.value()->geometry());
+    }
+    occlusion->setScreens(screens);
+}
+
+bool WallpaperEnginePrivate::isScreenVisible(const QString &screen) const
+{
+    return !occlusion || occlusion->isVisible(screen);
+}
+
+void WallpaperEnginePrivate::updatePlayState()
+{
+#ifndef USE_LIBDMR
+    if (!player)
+        return;
+
+    // the player is shared by all screens.
+    bool active = false;
+    for (const QString &screen : widgets.keys())
+        active = active || isScreenVisible(screen);
+
+    // the short clip is looped from ring without decoder.
+    if (ringActive) {
+        if (playing && active && pauseReasons == 0)
+            ring->play();
+        else
+            ring->stop();
+        return;
+    }
+
+    if (playing && active && pauseReasons == 0)
+        player->play();
+    else if (player->state() == QMediaPlayer::PlayingState)
+        player->pause();
+#else
+    // a decoder keeps running if any screen showing its frames can be seen.
+    for (auto itor = widgets.begin(); itor != widgets.end(); ++itor) {
+        VideoProxy *dec = itor.value().get();
+        if (!dec->isDecoding())
+            continue;
+
+        bool active = pauseReasons == 0 && isScreenVisible(itor.key());
+        for (auto mirror = widgets.begin(); !active && pauseReasons == 0 && mirror != widgets.end(); ++mirror)
+            active = mirror.value()->source() == dec && isScreenVisible(mirror.key());
+
+        dec->setPaused(!active);
+    }
+#endif
+}
+
+void WallpaperEnginePrivate::setPaused(PauseReason reason, bool paused)
+{
+    int reasons = paused ? (pauseReasons | reason) : (pauseReasons & ~reason);
+    if (reasons == pauseReasons)
+        return;
+
+    pauseReasons = reasons;
+    updatePlayState();
+    updateMemory();
+}
+
+void WallpaperEnginePrivate::applyPowerLevel()
+{
+    const PowerPolicy::Level lv = power ? power->level() : PowerPolicy::kNormal;
+    applyFrameRate();
+
+    const qreal scale = lv >= PowerPolicy::kReducedResolution ? WpCfg->powerThresholds().reducedScale : 1.0;
+#ifndef USE_LIBDMR
+    if (surface)
+        surface->setDecodeScale(scale);
+#else
+    for (const VideoProxyPointer &bwp : widgets.values())
+        bwp->setDecodeScale(scale);
+#endif
+
+    // the last frame is kept as a poster.
+    setPaused(kPauseByPower, lv >= PowerPolicy::kPoster);
+
+    updateVisibility();
+}
+
+void WallpaperEnginePrivate::updateVisibility()
+{
+    if (!playing)
+        return;
+
+    // show the static background instead of the video, or until the first frame is ready.
+    const bool hide = power && power->level() >= PowerPolicy::kPaused;
+    for (auto itor = widgets.begin(); itor != widgets.end(); ++itor) {
+        const bool show = !hide && itor.value()->hasFrame();
+        setBackgroundVisible(!show, itor.key());
+        itor.value()->setVisible(show);
+    }
+}
+
+void WallpaperEnginePrivate::applyFrameCache()
+{
+    FrameCacheConfig cfg = WpCfg->frameCache();
+    // no cache while the memory is over the limit, and the cached frames
+    // are scaled for one screen, not for the spanned canvas.
+    cfg.enable = cfg.enable && !(memory && memory->isOverLimit()) && !spanCanvas().isValid();
+    const qint64 maxLength = static_cast<qint64>(cfg.maxLength) * 1000;
+    const qint64 budget = static_cast<qint64>(cfg.budget) * 1024 * 1024;
+#ifndef USE_LIBDMR
+    if (!cfg.enable || !player) {
+        stopRing();
+        delete ring;
+        ring = nullptr;
+        return;
+    }
+
+    if (!ring) {
+        ring = new FrameRing;
+        QObject::connect(ring, &FrameRing::frameReady, q, &WallpaperEngine::catchImage);
+        // go back to decoder if the budget is exceeded.
+        QObject::connect(ring, &FrameRing::evicted, q, [this]() {
+            ringRejected = playlist->currentMedia().request().url();
+            stopRing();
+        });
+    }
+
+    if (ringMaxLength != maxLength)
+        ringRejected.clear();
+    ringMaxLength = maxLength;
+    ring->setBudget(budget);
+#else
+    for (const VideoProxyPointer &bwp : widgets.values())
+        bwp->setFrameCache(cfg.enable, maxLength, budget);
+#endif
+}
+
+void WallpaperEnginePrivate::applyScaleMode()
+{
+    const ScaleMode mode = WpCfg->scaleMode();
+    scaler->setMode(mode);
+#ifndef USE_LIBDMR
+    negotiateSurface();
+#else
+    for (const VideoProxyPointer &bwp : widgets.values())
+        bwp->setScaleMode(scaleMode());
+
+    // the screens of different shapes can not share the crop in fill and center mode.
+    shareDecoders();
+#endif
+}
+
+ScaleMode WallpaperEnginePrivate::scaleMode() const
+{
+    const ScaleMode mode = WpCfg->scaleMode();
+    return spanCanvas().isValid() ? ScaleGeometry::spanMode(mode) : mode;
+}
+
+QRect WallpaperEnginePrivate::spanCanvas(QMap<QString, QRect> *screens) const
+{
+    // nothing to span on a single screen.
+    if (!WpCfg->spanScreens() || widgets.size() < 2)
+        return QRect();
+
+    QRect canvas;
+    auto winMap = rootMap();
+    for (auto itor = winMap.begin(); itor != winMap.end(); ++itor) {
+        if (!widgets.contains(itor.key()))
+            continue;
+
+        // the position of screen is in native pixels and only its size is scaled in Qt5,
+        // so the screens of different device pixel ratios are laid out in pixels.
+        const QRect geo = itor.value()->geometry();
+        const QRect rect(geo.topLeft(), geo.size() * itor.value()->devicePixelRatioF());
+        canvas = canvas.united(rect);
+        if (screens)
+            screens->insert(itor.key(), rect);
+    }
+    return canvas;
+}
+
+void WallpaperEnginePrivate::updateMemory()
+{
+    // the frames of the screens which can not be seen are dropped after a while.
+    bool idle = false;
+    for (auto itor = widgets.begin(); itor != widgets.end(); ++itor) {
+        if (isScreenActive(itor.key()))
+            itor.value()->setSuspended(false);
+        else
+            idle = true;
+    }
+
+    if (!idle)
+        trimTimer.stop();
+    else if (!trimTimer.isActive())
+        trimTimer.start();
+}
+
+bool WallpaperEnginePrivate::isScreenActive(const QString &screen) const
+{
+    // the last frame is kept as a poster when paused by power.
+    static constexpr int kTrimReasons = kPauseByLock | kPauseByIdle | kPauseByBlank | kPauseBySleep;
+    if (standby || (pauseReasons & kTrimReasons))
+        return false;
+
+    if (isScreenVisible(screen))
+        return true;
+
+#ifdef USE_LIBDMR
+    // a decoder is active if any screen showing its frames can be seen.
+    VideoProxy *dec = widgets.value(screen).get();
+    for (auto itor = widgets.begin(); itor != widgets.end(); ++itor) {
+        if (itor.value()->source() == dec && isScreenVisible(itor.key()))
+            return true;
+    }
+#endif
+    return false;
+}
+
+void WallpaperEnginePrivate::trimIdle()
+{
+    qint64 bytes = 0;
+    for (auto itor = widgets.begin(); itor != widgets.end(); ++itor) {
+        if (isScreenActive(itor.key()))
+            continue;
+
+        bytes += itor.value()->imageBytes();
+        itor.value()->setSuspended(true);
+    }
+
+#ifndef USE_LIBDMR
+    // the player is shared, the idle buffers are released only if all screens are idle.
+    bool active = false;
+    for (const QString &screen : widgets.keys())
+        active = active || isScreenActive(screen);
+    if (!active)
+        bytes += FrameBufferPool::instance()->trim();
+#endif
+    MemoryManager::releaseHeap();
+    updateVisibility();
+    fmDebug() << "trim idle frames" << bytes << "resident" << PerfCounters::residentBytes();
+}
+
+void WallpaperEnginePrivate::applyMemoryLimit()
+{
+    if (memory)
+        memory->setLimit(static_cast<qint64>(WpCfg->memoryLimit()) * 1024 * 1024);
+}
+
+void WallpaperEnginePrivate::setMemoryTight(bool tight)
+{
+    // the optional caches are disabled until the resident size goes down.
+    applyFrameCache();
+#ifdef USE_LIBDMR
+    for (const VideoProxyPointer &bwp : widgets.values())
+        bwp->setPreroll(!tight);
+#else
+    Q_UNUSED(tight)
+#endif
+}
+
+void WallpaperEnginePrivate::enterStandby(int timeout)
+{
+    standby = true;
+    standbySince.start();
+    standbyRssBefore = PerfCounters::residentBytes();
+    standbyTrimmed = 0;
+    playing = false;
+    setPaused(kPauseByStandby, true);
+
+#ifndef USE_LIBDMR
+    stopRing();
+    standbyTrimmed += FrameBufferPool::instance()->trim();
+#endif
+    for (const VideoProxyPointer &bwp : widgets.values()) {
+        bwp->setSuspended(true);
+        bwp->hide();
+    }
+    setBackgroundVisible(true);
+
+    standbyTimer.start(timeout * 1000);
+    fmInfo() << "enter standby for" << timeout << "s, resident" << standbyRssBefore
+             << "->" << PerfCounters::residentBytes() << "trimmed" << standbyTrimmed;
+}
+
+void WallpaperEnginePrivate::leaveStandby()
+{
+    standbyTimer.stop();
+    standby = false;
+    for (const VideoProxyPointer &bwp : widgets.values())
+        bwp->setSuspended(false);
+    setPaused(kPauseByStandby, false);
+    fmInfo() << "leave standby after" << standbySince.elapsed() << "ms";
+}
+
+QVariantMap WallpaperEnginePrivate::perfStats() const
+{
+    QVariantMap ret;
+    ret.insert("playing", playing);
+    if (memory)
+        ret.insert("memory", memory->stats());
+    if (standby) {
+        QVariantMap map;
+        map.insert("seconds", standbySince.elapsed() / 1000);
+        map.insert("timeout", standbyTimer.interval() / 1000);
+        map.insert("residentBefore", standbyRssBefore);
+        map.insert("resident", PerfCounters::residentBytes());
+        map.insert("trimmedBytes", standbyTrimmed);
+        ret.insert("standby", map);
+    }
+    ret.insert("pauseReasons", pauseReasons);
+    ret.insert("powerLevel", power ? static_cast<int>(power->level()) : 0);
+#ifndef USE_LIBDMR
+    ret.insert("videos", videos.size());
+#else
+    QVariantMap lists;
+    for (auto itor = videos.begin(); itor != videos.end(); ++itor)
+        lists.insert(itor.key(), itor.value().size());
+    ret.insert("videos", lists);
+#endif
+    const QRect canvas = spanCanvas();
+    if (canvas.isValid())
+        ret.insert("spanCanvas", QString("%0x%1").arg(canvas.width()).arg(canvas.height()));
+#ifndef USE_LIBDMR
+    ret.insert("hwdec", "unknown");   // decided by the backend of QtMultimedia
+    const FrameCounters stat = FrameBufferPool::instance()->counters();
+    QVariantMap pool;
+    pool.insert("frames", stat.frames);
+    pool.insert("shared", stat.shared);
+    pool.insert("copied", stat.copied);
+    pool.insert("copiedBytes", stat.copiedBytes);
+    pool.insert("allocations", stat.allocations);
+    pool.insert("allocatedBytes", stat.allocatedBytes);
+    ret.insert("framePool", pool);
+
+    QVariantMap gapMap;
+    gapMap.insert("lastMs", gap.last());
+    gapMap.insert("maxMs", gap.max());
+    gapMap.insert("avgMs", gap.average());
+    gapMap.insert("count", gap.count());
+    gapMap.insert("overFrame", gap.overruns());
+    ret.insert("transitionGap", gapMap);
+
+    if (ring) {
+        ret.insert("fromRing", ringActive);
+        ret.insert("ringBytes", ring->bytes());
+        ret.insert("ringFrames", ring->count());
+        ret.insert("ringEvictions", ring->evictions());
+    }
+#else
+    // the decoders are tracked per screen.
+    QVariantMap decoders;
+    for (auto itor = widgets.begin(); itor != widgets.end(); ++itor) {
+        if (itor.value()->isDecoding())
+            decoders.insert(itor.key(), itor.value()->decoderStats());
+    }
+    ret.insert("decoders", decoders);
+    if (clock)
+        ret.insert("clock", clock->stats());
+#endif
+    return ret;
+}
+
+QSize WallpaperEnginePrivate::transcodeSize() const
+{
+    // one rendition covers the spanned canvas, or fits the largest screen.
+    const QRect canvas = spanCanvas();
+    if (canvas.isValid())
+        return canvas.size();
+
+    QSize ret;
+    auto winMap = rootMap();
+    for (auto itor = winMap.begin(); itor != winMap.end(); ++itor) {
+        const QSize size = itor.value()->geometry().size() * itor.value()->devicePixelRatioF();
+        if (size.width() * size.height() > ret.width() * ret.height())
+            ret = size;
+    }
+    return ret;
+}
+
+void WallpaperEnginePrivate::updateCache()
+{
+    // the renditions for the old size are no longer used.
+    if (cache && transcodeSize() != cacheSize)
+        q->refreshSource();
+}
+
+#ifndef USE_LIBDMR
+void WallpaperEnginePrivate::updatePlaylist()
+{
+    // only apply the changes, the playing item is kept if its file is still there.
+    const int cur = playlist->currentIndex();
+    for (int i = playlist->mediaCount() - 1; i >= 0; --i) {
+        const QMediaContent media = playlist->media(i);
+        if (videos.contains(media))
+            continue;
+
+        if (i == cur && QFileInfo::exists(media.request().url().toLocalFile()))
+            continue;
+
+        playlist->removeMedia(i);
+    }
+
+    int pos = 0;
+    for (const QMediaContent &media : videos) {
+        int idx = -1;
+        for (int i = 0; i < playlist->mediaCount() && idx < 0; ++i) {
+            if (playlist->media(i) == media)
+                idx = i;
+        }
+
+        if (idx < 0) {
+            playlist->insertMedia(pos, media);
+            idx = pos;
+        }
+        pos = idx + 1;
+    }
+
+    if (playlist->currentIndex() < 0 && !playlist->isEmpty())
+        playlist->setCurrentIndex(0);
+}
+
+void WallpaperEnginePrivate::recordFrame(const QImage &img)
+{
+    if (!ring || ringActive || playlist->mediaCount() != 1)
+        return;
+
+    const QUrl url = playlist->media(0).request().url();
+    const qint64 duration = player->duration();
+    if (url == ringRejected || duration <= 0)
+        return;
+
+    if (duration > ringMaxLength) {
+        ringRejected = url;
+        return;
+    }
+
+    const qint64 pts = player->position();
+    if (ring->state() == FrameRing::kIdle) {
+        // wait for the beginning of a loop.
+        if (pts > kRingStartWindow)
+            return;
+
+        fmInfo() << "record frames of" << url << duration << "ms";
+        ring->start();
+        ringRegion = surface->frameRegion();
+        ringTarget = surface->targetSize();
+        lastPts = -1;
+    }
+
+    // the clip looped, all frames are kept.
+    if (lastPts >= 0 && pts < lastPts) {
+        if (!ring->finish(duration)) {
+            ringRejected = url;
+            return;
+        }
+
+        fmInfo() << "stop decoding" << url;
+        ringActive = true;
+        player->stop();
+        updatePlayState();
+        return;
+    }
+
+    lastPts = pts;
+
+    // no need to keep more pixels than the largest screen.
+    QSize size;
+    for (const VideoProxyPointer &bwp : widgets.values()) {
+        const QSize fs = bwp->frameSize();
+        if (fs.width() * fs.height() > size.width() * size.height())
+            size = fs;
+    }
+
+    QImage frame = img;
+    if (size.isValid() && (img.width() > size.width() || img.height() > size.height()))
+        frame = img.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+    if (!ring->append(frame, pts))
+        ringRejected = url;
+}
+
+void WallpaperEnginePrivate::negotiateSurface()
+{
+    if (!surface)
+        return;
+
+    // only the region visible on any screen is converted, and it is
+    // converted at the largest scale that any screen needs.
+    const QSize frame = surface->surfaceFormat().frameSize();
+    const ScaleMode mode = scaler->mode();
+    QMap<QString, QRect> screens;
+    const QRect canvas = spanCanvas(&screens);
+    QRectF region;
+    qreal sx = 0;
+    qreal sy = 0;
+    if (frame.isValid() && canvas.isValid()) {
+        // the frame is converted for the spanned canvas.
+        const ScaleGeometry geo = ScaleGeometry::compute(frame, canvas.size(), ScaleGeometry::spanMode(mode));
+        if (!geo.source.isEmpty()) {
+            sx = qreal(geo.target.width()) / geo.source.width();
+            sy = qreal(geo.target.height()) / geo.source.height();
+            region = normalizedIn(geo.source, QRect(QPoint(0, 0), frame));
+        }
+    } else if (frame.isValid()) {
+        for (const VideoProxyPointer &bwp : widgets.values()) {
+            const ScaleGeometry geo = ScaleGeometry::compute(frame, bwp->frameSize(), mode);
+            if (geo.source.isEmpty())
+                continue;
+
+            sx = qMax(sx, qreal(geo.target.width()) / geo.source.width());
+            sy = qMax(sy, qreal(geo.target.height()) / geo.source.height());
+            if (mode == kScaleFill || mode == kScaleCenter)
+                region = region.united(normalizedIn(geo.source, QRect(QPoint(0, 0), frame)));
+        }
+    }
+
+    if (region.isEmpty())
+        region = QRectF(0, 0, 1, 1);
+
+    // each spanned screen takes its part of the converted region.
+    for (auto itor = widgets.begin(); itor != widgets.end(); ++itor) {
+        QRectF part;
+        if (canvas.isValid()) {
+            const QRectF r = normalizedIn(screens.value(itor.key()), canvas);
+            part = QRectF(region.x() + r.x() * region.width(), region.y() + r.y() * region.height(),
+                          r.width() * region.width(), r.height() * region.height());
+        }
+        itor.value()->setSpanRegion(part);
+    }
+
+    QSize target;
+    if (sx > 0 && sy > 0)
+        target = QSize(qCeil(frame.width() * qMin(sx, 1.0)), qCeil(frame.height() * qMin(sy, 1.0)));
+
+    // the frames in ring have the old region and size.
+    if (ring && ring->state() != FrameRing::kIdle && (region != ringRegion || target != ringTarget))
+        stopRing();
+
+    if (target != surface->targetSize())
+        fmDebug() << "surface target size" << target << "of" << frame;
+
+    surface->setSourceRegion(region);
+    surface->setTargetSize(target);
+}
+
+void WallpaperEnginePrivate::stopRing()
+{
+    lastPts = -1;
+    if (ring)
+        ring->clear();
+
+    if (ringActive) {
+        fmInfo() << "resume decoding";
+        ringActive = false;
+        updatePlayState();
+    }
+}
+#else
+void WallpaperEnginePrivate::updatePlaylists()
+{
+    // the screens of the same source share the list.
+    QMap<QString, QList<QUrl>> lists;   // source -- videos
+    QList<QUrl> files;
+    videos.clear();
+    for (const QString &screen : widgets.keys()) {
+        const QString source = sourceOf(screen);
+        if (!lists.contains(source)) {
+            lists.insert(source, getVideos(source));
+            files.append(sourceVideos(source));
+        }
+        videos.insert(screen, lists.value(source));
+    }
+
+    // only the videos to be played are transcoded, the cache is not touched before the index is ready.
+    if (cache && index && index->isReady())
+        cache->request(files, cacheSize, index->entries());
+}
+
+QString WallpaperEnginePrivate::playlistKey(const QString &screen) const
+{
+    // the screens of different sources resolving to the same videos share them too.
+    QStringList files;
+    for (const QUrl &url : videos.value(screen))
+        files.append(url.toString());
+    return files.join('\n');
+}
+
+QString WallpaperEnginePrivate::streamKey(const QString &screen) const
+{
+    QString key = playlistKey(screen);
+
+    // all screens show the parts of one frame.
+    if (spanCanvas().isValid())
+        return key.append("\nspan");
+
+    // the frames are cropped for the screen, they can not be shared by the screens of other shapes.
+    const ScaleMode mode = scaler->mode();
+    VideoProxyPointer bwp = widgets.value(screen);
+    if (bwp && mode == kScaleFill) {
+        const QSize size = bwp->frameSize();
+        key.append(QString("\n%0").arg(size.height() > 0 ? qreal(size.width()) / size.height() : 0, 0, 'f', 3));
+    } else if (bwp && mode == kScaleCenter) {
+        const QSize size = bwp->frameSize();
+        key.append(QString("\n%0x%1").arg(size.width()).arg(size.height()));
+    }
+    return key;
+}
+
+void WallpaperEnginePrivate::shareDecoders()
+{
+    // the screens playing the same content use one decoder, the others only paint its frames.
+    QMap<QString, VideoProxyPointer> decoders;   // stream -- decoding widget
+    for (auto itor = widgets.begin(); itor != widgets.end(); ++itor) {
+        const QString key = streamKey(itor.key());
+        if (itor.value()->isDecoding() && !decoders.contains(key))
+            decoders.insert(key, itor.value());
+    }
+
+    for (auto itor = widgets.begin(); itor != widgets.end(); ++itor) {
+        const QString key = streamKey(itor.key());
+        VideoProxyPointer dec = decoders.value(key);
+        if (dec.isNull()) {
+            dec = itor.value();
+            decoders.insert(key, dec);
+        }
+        itor.value()->setSource(dec.get());
+    }
+
+    for (const VideoProxyPointer &dec : decoders.values()) {
+        bool mirrored = false;
+        for (const VideoProxyPointer &bwp : widgets.values())
+            mirrored = mirrored || bwp->source() == dec.get();
+
+        dec->setMirrored(mirrored);
+        if (mirrored)
+            QObject::connect(dec.get(), &VideoProxy::frameReady, q, &WallpaperEngine::catchImage, Qt::UniqueConnection);
+    }
+
+    negotiateDecoders();
+
+    // the decoders of the same list are kept in step.
+    if (clock) {
+        QMap<QString, QList<VideoProxy *>> groups;   // playlist -- decoders
+        for (auto itor = widgets.begin(); itor != widgets.end(); ++itor) {
+            if (!itor.value()->source())
+                groups[playlistKey(itor.key())].append(itor.value().get());
+        }
+        clock->setGroups(groups.values());
+    }
+}
+
+void WallpaperEnginePrivate::negotiateDecoders()
+{
+    // each spanned screen shows its part of the canvas.
+    QMap<QString, QRect> screens;
+    const QRect canvas = spanCanvas(&screens);
+    for (auto itor = widgets.begin(); itor != widgets.end(); ++itor)
+        itor.value()->setSpanRegion(canvas.isValid() ? normalizedIn(screens.value(itor.key()), canvas) : QRectF());
+
+    // a decoder outputs the largest size among the screens painting its frames,
+    // or the size of canvas if spanning.
+    QMap<VideoProxy *, QSize> sizes;
+    for (const VideoProxyPointer &bwp : widgets.values()) {
+        // a decoding widget has no source.
+        VideoProxy *dec = bwp->source() ? bwp->source() : bwp.get();
+        sizes[dec] = canvas.isValid() ? canvas.size() : sizes.value(dec).expandedTo(bwp->frameSize());
+    }
+
+    for (const VideoProxyPointer &bwp : widgets.values())
+        bwp->negotiateSize(sizes.value(bwp.get()));
+}
+#endif
+
 WallpaperEngine::WallpaperEngine(QObject *parent)
     : QObject(parent)
     , d(new WallpaperEnginePrivate(this))
 {
+    d->scaler = new FrameScaler(this);
+
+    d->trimTimer.setSingleShot(true);
+    d->trimTimer.setInterval(kTrimDelay);
+    connect(&d->trimTimer, &QTimer::timeout, this, [this]() {
+        d->trimIdle();
+    });
 
+    // release the players kept in standby.
+    d->standbyTimer.setSingleShot(true);
+    connect(&d->standbyTimer, &QTimer::timeout, this, &WallpaperEngine::turnOff);
 }
 
 WallpaperEngine::~WallpaperEngine()
@@ -132,11 +981,11 @@ bool WallpaperEngine::init()
 {
     WpCfg->initialize();
 
-    QFileInfo source(d->sourcePath());
-    if (!source.exists()) {
-        source.absoluteDir().mkpath(source.fileName());
-    }
-    fmInfo() << "the wallpaper resource is in" << source.absoluteFilePath();
+    // not on the critical path of startup.
+    d->perf = new PerfCountersDBus(this);
+    QTimer::singleShot(0, d->perf, [this]() {
+        d->perf->registerOn();
+    });
 
     if (!registerMenu()) {
         // waiting canvas menu
@@ -148,31 +997,139 @@ bool WallpaperEngine::init()
             return;
         WpCfg->setEnable(e);
         if (e) {
-            turnOn();
-            play();
-        } else
-            turnOff();
+            CanvasCoreUnsubscribe(signal_DesktopFrame_WindowShowed, &WallpaperEngine::startDeferred);
+            if (d->standby) {
+                d->leaveStandby();
+                play();
+            } else if (!d->watcher) {
+                turnOn();
+                play();
+            }
+        } else {
+            // the players are kept for a while to be enabled again quickly.
+            const int timeout = WpCfg->standbyTimeout();
+            if (timeout > 0 && d->watcher && !d->standby)
+                d->enterStandby(timeout);
+            else
+                turnOff();
+        }
+    });
+    connect(WpCfg, &WallpaperConfig::changeMaxFps, this, [this]() {
+        d->applyFrameRate();
+    });
+    connect(WpCfg, &WallpaperConfig::changePowerPolicy, this, [this]() {
+        if (d->power)
+            d->power->setThresholds(WpCfg->powerThresholds());
+        d->applyPowerLevel();
+    });
+    connect(WpCfg, &WallpaperConfig::changeScaleMode, this, [this]() {
+        d->applyScaleMode();
+    });
+    connect(WpCfg, &WallpaperConfig::changeFrameCache, this, [this]() {
+        d->applyFrameCache();
+    });
+    connect(WpCfg, &WallpaperConfig::changeMemoryLimit, this, [this]() {
+        d->applyMemoryLimit();
+    });
+    connect(WpCfg, &WallpaperConfig::changeScreenSources, this, [this]() {
+        if (!d->watcher)
+            return;
+
+        d->updateSources();
+        refreshSource();
+    });
+    connect(WpCfg, &WallpaperConfig::changeSpanScreens, this, [this]() {
+        d->applyFrameCache();
+        d->applyScaleMode();
+        d->updateCache();
+    });
+    connect(WpCfg, &WallpaperConfig::changeTranscodeCache, this, [this](bool e) {
+        if (!WpCfg->enable())
+            return;
+
+        delete d->cache;
+        d->cache = nullptr;
+        if (e) {
+            d->cache = new TranscodeCache(this);
+            connect(d->cache, &TranscodeCache::cacheUpdated, this, &WallpaperEngine::refreshSource);
+        }
+        refreshSource();
     });
 
-    if (WpCfg->enable())
-        turnOn(false);
+    // the players are created and the videos are scanned after the desktop is shown.
+    if (WpCfg->enable()) {
+        bool shown = false;
+        for (QWidget *root : ddplugin_desktop_util::desktopFrameRootWindows())
+            shown = shown || root->isVisible();
+
+        if (shown)
+            QMetaObject::invokeMethod(this, "startDeferred", Qt::QueuedConnection);
+        else
+            CanvasCoreSubscribe(signal_DesktopFrame_WindowShowed, &WallpaperEngine::startDeferred);
+    }
 
+    PerfCounters::instance()->mark("engineInit");
     return true;
 }
 
+void WallpaperEngine::startDeferred()
+{
+    CanvasCoreUnsubscribe(signal_DesktopFrame_WindowShowed, &WallpaperEngine::startDeferred);
+    PerfCounters::instance()->mark("desktopShown");
+
+    // let the desktop finish painting first.
+    QTimer::singleShot(0, this, [this]() {
+        if (!WpCfg->enable() || d->watcher)
+            return;
+
+        turnOn();
+        play();
+    });
+}
+
 void WallpaperEngine::turnOn(bool b)
 {
     Q_ASSERT(d->watcher == nullptr);
+    PerfCounters::instance()->mark("turnOn");
+
+    QFileInfo source(d->sourcePath());
+    if (!source.exists()) {
+        source.absoluteDir().mkpath(source.fileName());
+    }
+    fmInfo() << "the wallpaper resource is in" << source.absoluteFilePath();
 
     CanvasCoreSubscribe(signal_DesktopFrame_WindowShowed, &WallpaperEngine::play);
     CanvasCoreSubscribe(signal_DesktopFrame_WindowBuilded, &WallpaperEngine::build);
     CanvasCoreSubscribe(signal_DesktopFrame_GeometryChanged, &WallpaperEngine::geometryChanged);
     CanvasCoreUnsubscribe(signal_DesktopFrame_WindowAboutToBeBuilded, &WallpaperEngine::onDetachWindows);
 
+    // the playlist is updated after the files are probed.
+    d->index = new MediaIndex(this);
+    connect(d->index, &MediaIndex::updated, this, [this](const MediaDiff &diff) {
+        if (!diff.isEmpty())
+            refreshSource();
+        if (d->checkPending) {
+            d->checkPending = false;
+            checkResouce();
+        }
+    });
+
+#ifdef USE_LIBDMR
+    d->probes = new DecoderProbeCache(new SystemProbeBackend(d->index));
+    d->clock = new PlaybackClock(this);
+#endif
+
     d->watcher = new QFileSystemWatcher(this);
     {
-        d->watcher->addPath(d->sourcePath());
-        connect(d->watcher, &QFileSystemWatcher::directoryChanged, this, &WallpaperEngine::refreshSource);
+        connect(d->watcher, &QFileSystemWatcher::directoryChanged, d->index, [this]() {
+            d->index->scheduleScan(d->sourceDirs());
+        });
+        // the playlist is edited.
+        connect(d->watcher, &QFileSystemWatcher::fileChanged, this, [this]() {
+            d->updateSources();
+            refreshSource();
+        });
+        d->updateSources();
     }
 #ifndef USE_LIBDMR
     d->surface = new VideoSurface;
@@ -180,28 +1137,166 @@ void WallpaperEngine::turnOn(bool b)
     d->player = new QMediaPlayer(nullptr, QMediaPlayer::LowLatency);
 
     connect(d->surface, &VideoSurface::pushImage, this, &WallpaperEngine::catchImage);
+    connect(d->surface, &QAbstractVideoSurface::surfaceFormatChanged, this, [this]() {
+        d->negotiateSurface();
+    });
 
     d->player->setVideoOutput(d->surface);
     d->player->setMuted(true);
     d->playlist = new QMediaPlaylist(d->player);
+    d->playlist->setPlaybackMode(QMediaPlaylist::Loop);
+    d->player->setPlaylist(d->playlist);
+    // QMediaPlayer reopens the media for each item, see how long it takes.
+    connect(d->player, &QMediaPlayer::currentMediaChanged, this, [this]() {
+        d->gap.start();
+    });
+    // drop the replaced item after it is played.
+    connect(d->playlist, &QMediaPlaylist::currentIndexChanged, this, [this]() {
+        if (d->playlist)
+            d->updatePlaylist();
+    }, Qt::QueuedConnection);
 #endif
+    d->occlusion = new OcclusionTracker(new WindowSource, this);
+    connect(d->occlusion, &OcclusionTracker::visibilityChanged, this, [this]() {
+        d->updatePlayState();
+        d->updateMemory();
+    });
+
+    d->power = new PowerPolicy(new SysfsPowerProvider, WpCfg->powerThresholds(), this);
+    connect(d->power, &PowerPolicy::levelChanged, this, [this]() {
+        d->applyPowerLevel();
+    });
+
+    // the last frame is kept while paused, nothing to rebuild after resuming.
+    d->session = new DBusSessionSource(this);
+    connect(d->session, &AbstractSessionSource::lockChanged, this, [this](bool on) {
+        d->setPaused(kPauseByLock, on);
+    });
+    connect(d->session, &AbstractSessionSource::idleChanged, this, [this](bool on) {
+        d->setPaused(kPauseByIdle, on);
+    });
+    connect(d->session, &AbstractSessionSource::blankChanged, this, [this](bool on) {
+        d->setPaused(kPauseByBlank, on);
+    });
+    connect(d->session, &AbstractSessionSource::sleepChanged, this, [this](bool on) {
+        d->setPaused(kPauseBySleep, on);
+    });
+
+    if (WpCfg->transcodeCache()) {
+        d->cache = new TranscodeCache(this);
+        connect(d->cache, &TranscodeCache::cacheUpdated, this, &WallpaperEngine::refreshSource);
+    }
+
+    PerfCounters::instance()->setSource("engine", [this]() {
+        return d->perfStats();
+    });
+
+    d->memory = new MemoryManager(this);
+    d->memory->track("images", [this]() {
+        qint64 bytes = 0;
+        for (const VideoProxyPointer &bwp : d->widgets.values())
+            bytes += bwp->imageBytes();
+        return bytes;
+    });
+#ifndef USE_LIBDMR
+    d->memory->track("framePool", []() {
+        return FrameBufferPool::instance()->idleBytes();
+    }, []() {
+        return FrameBufferPool::instance()->trim();
+    });
+    d->memory->track("frameRing", [this]() {
+        return d->ring ? d->ring->bytes() : qint64(0);
+    }, [this]() {
+        const qint64 bytes = d->ring ? d->ring->bytes() : 0;
+        d->stopRing();
+        return bytes;
+    });
+#else
+    d->memory->track("frameRing", [this]() {
+        qint64 bytes = 0;
+        for (const VideoProxyPointer &bwp : d->widgets.values())
+            bytes += bwp->ringBytes();
+        return bytes;
+    }, [this]() {
+        qint64 bytes = 0;
+        for (const VideoProxyPointer &bwp : d->widgets.values())
+            bytes += bwp->releaseCaches();
+        return bytes;
+    });
+#endif
+    connect(d->memory, &MemoryManager::limitExceeded, this, [this]() {
+        d->setMemoryTight(true);
+    });
+    connect(d->memory, &MemoryManager::limitRecovered, this, [this]() {
+        d->setMemoryTight(false);
+    });
+    d->applyMemoryLimit();
+
+    d->applyPowerLevel();
+    d->applyFrameCache();
+    d->applyScaleMode();
     refreshSource();
+    d->index->scan(d->sourceDirs());
     if (b) {
         build();
         show();
     }
+    PerfCounters::instance()->mark("turnOnFinished");
 }
 
 void WallpaperEngine::turnOff()
 {
+    // the deferred start is cancelled.
+    CanvasCoreUnsubscribe(signal_DesktopFrame_WindowShowed, &WallpaperEngine::startDeferred);
+    if (!d->watcher)
+        return;
+
+    const qint64 rss = d->standby ? PerfCounters::residentBytes() : 0;
+    d->standbyTimer.stop();
+    d->trimTimer.stop();
+
     CanvasCoreUnsubscribe(signal_DesktopFrame_WindowShowed, &WallpaperEngine::play);
     CanvasCoreUnsubscribe(signal_DesktopFrame_WindowBuilded, &WallpaperEngine::build);
     CanvasCoreUnsubscribe(signal_DesktopFrame_WindowBuilded, &WallpaperEngine::onDetachWindows);
     CanvasCoreUnsubscribe(signal_DesktopFrame_GeometryChanged, &WallpaperEngine::geometryChanged);
 
+    PerfCounters::instance()->removeSource("engine");
+
     delete d->watcher;
     d->watcher = nullptr;
+
+#ifdef USE_LIBDMR
+    for (const VideoProxyPointer &bwp : d->widgets.values())
+        bwp->setProbeCache(nullptr);
+    delete d->probes;
+    d->probes = nullptr;
+    delete d->clock;
+    d->clock = nullptr;
+#endif
+
+    delete d->index;
+    d->index = nullptr;
+    d->checkPending = false;
+
+    delete d->occlusion;
+    d->occlusion = nullptr;
+
+    delete d->power;
+    d->power = nullptr;
+
+    delete d->session;
+    d->session = nullptr;
+
+    delete d->cache;
+    d->cache = nullptr;
+    d->cacheSize = QSize();
+    d->playing = false;
+    d->pauseReasons = 0;
 #ifndef USE_LIBDMR
+    delete d->ring;
+    d->ring = nullptr;
+    d->ringActive = false;
+    d->ringRejected.clear();
     d->player->pause();
 
     delete d->playlist;
@@ -216,31 +1311,46 @@ void WallpaperEngine::turnOff()
     d->widgets.clear();
     d->videos.clear();
 
+    delete d->memory;
+    d->memory = nullptr;
+
     // show background.
     d->setBackgroundVisible(true);
+    // the freed players and frames go back to system.
+    MemoryManager::releaseHeap();
+
+    if (d->standby) {
+        d->standby = false;
+        fmInfo() << "release standby, resident" << rss << "->" << PerfCounters::residentBytes();
+    }
 }
 
 void WallpaperEngine::refreshSource()
 {
-    d->videos = d->getVideos(d->sourcePath());
-
+    d->cacheSize = d->transcodeSize();
 #ifndef USE_LIBDMR
-    bool run = d->player->state() == QMediaPlayer::PlayingState;
-
-    d->playlist->clear();
-    d->playlist->addMedia(d->videos);
-    if (!d->videos.isEmpty()) {
-        d->playlist->setCurrentIndex(0);
-        d->playlist->setPlaybackMode(QMediaPlaylist::Loop);
+    d->videos = d->getVideos();
+    // the cache is not touched before the index is ready.
+    if (d->cache && d->index && d->index->isReady())
+        d->cache->request(d->sourceVideos(d->sourceOf(QString())), d->cacheSize, d->index->entries());
+
+    if (d->ringActive || (d->ring && d->ring->state() != FrameRing::kIdle)) {
+        QList<QMediaContent> old;
+        for (int i = 0; i < d->playlist->mediaCount(); ++i)
+            old.append(d->playlist->media(i));
+        if (old != d->videos)
+            d->stopRing();
     }
 
-    d->player->setPlaylist(d->playlist);
-
-    if (run)
-        d->player->play();
+    d->updatePlaylist();
+    d->updatePlayState();
 #else
-    for (const VideoProxyPointer &bwp : d->widgets.values())
-        bwp->setPlayList(d->videos);
+    d->updatePlaylists();
+    for (auto itor = d->widgets.begin(); itor != d->widgets.end(); ++itor)
+        itor.value()->setPlayList(d->videos.value(itor.key()));
+
+    // a widget becoming decoder starts from its new list.
+    d->shareDecoders();
 #endif
 }
 
@@ -308,6 +1418,22 @@ void WallpaperEngine::build()
             }
         }
     }
+
+    // the sources of the added screens are scanned.
+    d->updateSources();
+#ifdef USE_LIBDMR
+    d->updatePlaylists();
+#endif
+    d->applyPowerLevel();
+    d->applyScaleMode();
+    // the screens may be spanned or not after adding or removing.
+    d->applyFrameCache();
+#ifdef USE_LIBDMR
+    d->shareDecoders();
+#endif
+    d->updateScreens();
+    d->updatePlayState();
+    d->updateCache();
 }
 
 void WallpaperEngine::onDetachWindows()
@@ -332,19 +1458,29 @@ void WallpaperEngine::geometryChanged()
             bw->setGeometry(geometry);
         }
     }
+
+    d->updateScreens();
+#ifndef USE_LIBDMR
+    d->negotiateSurface();
+#else
+    // the shape or the device pixel ratio may be changed without resizing.
+    d->shareDecoders();
+#endif
+    d->updateCache();
 }
 
 void WallpaperEngine::play()
 {
     if (WpCfg->enable()) {
-#ifndef USE_LIBDMR
-        d->player->play();
-#else
-        for (const VideoProxyPointer &bwp : d->widgets.values())
-            bwp->setPlayList(d->videos);
+        d->playing = true;
+#ifdef USE_LIBDMR
+        for (auto itor = d->widgets.begin(); itor != d->widgets.end(); ++itor)
+            itor.value()->setPlayList(d->videos.value(itor.key()));
 #endif
-        d->setBackgroundVisible(false);
+        d->updatePlayState();
         show();
+        d->applyPowerLevel();
+        d->updateMemory();
     }
 }
 
@@ -352,8 +1488,11 @@ void WallpaperEngine::show()
 {
     // relayout
     dpfSlotChannel->push("ddplugin_core", "slot_DesktopFrame_LayoutWidget");
-    for (const VideoProxyPointer &bwp : d->widgets.values())
-        bwp->show();
+    // the others are shown after their first frames.
+    for (const VideoProxyPointer &bwp : d->widgets.values()) {
+        if (bwp->hasFrame())
+            bwp->show();
+    }
 }
 
 bool WallpaperEngine::registerMenu()
@@ -371,8 +1510,29 @@ bool WallpaperEngine::registerMenu()
 
 void WallpaperEngine::checkResouce()
 {
-    if (d->videos.isEmpty()) {
-       QString text = tr("Please add the video file to %0").arg(d->sourcePath());
+    // the videos are unknown before probing.
+    if (d->index && d->index->isScanning()) {
+        d->checkPending = true;
+        return;
+    }
+
+    QString empty;
+#ifndef USE_LIBDMR
+    if (d->videos.isEmpty())
+        empty = d->sourcePath();
+#else
+    // the screens are not built yet.
+    if (d->videos.isEmpty() && d->getVideos(d->sourceOf(QString())).isEmpty())
+        empty = d->sourcePath();
+
+    for (auto itor = d->videos.begin(); empty.isEmpty() && itor != d->videos.end(); ++itor) {
+        if (itor.value().isEmpty())
+            empty = d->sourceOf(itor.key());
+    }
+#endif
+
+    if (!empty.isEmpty()) {
+       QString text = tr("Please add the video file to %0").arg(empty);
        QDBusInterface notify("org.freedesktop.Notifications", "/org/freedesktop/Notifications", "org.freedesktop.Notifications");
        notify.setTimeout(1000);
        QDBusPendingReply<uint> p = notify.asyncCall(QString("Notify"),
@@ -384,10 +1544,36 @@ void WallpaperEngine::checkResouce()
     }
 }
 
-#ifndef USE_LIBDMR
 void WallpaperEngine::catchImage(const QImage &img)
 {
-    for (const VideoProxyPointer &bwp : d->widgets.values())
-        bwp->updateImage(img);
-}
+#ifdef USE_LIBDMR
+    // the frame is decoded by sender.
+    VideoProxy *decoder = qobject_cast<VideoProxy *>(sender());
+#else
+    if (sender() == d->surface)
+        d->recordFrame(img);
+
+    if (d->gap.isRunning()) {
+        const qreal fps = d->player->metaData("VideoFrameRate").toReal();
+        d->gap.finish(fps > 0 ? 1000 / fps : 0);
+    }
+#endif
+    QList<VideoProxyPointer> targets;
+    for (auto itor = d->widgets.begin(); itor != d->widgets.end(); ++itor) {
+#ifdef USE_LIBDMR
+        if (itor.value()->source() != decoder)
+            continue;
 #endif
+        // no need to update the covered screen.
+        if (d->isScreenVisible(itor.key()))
+            targets.append(itor.value());
+    }
+
+    // scale it in worker threads.
+#ifndef USE_LIBDMR
+    const QRectF region = sender() == d->surface ? d->surface->frameRegion() : d->ringRegion;
+    d->scaler->scale(img, targets, region);
+#else
+    d->scaler->scale(img, targets);
+#endif
+}
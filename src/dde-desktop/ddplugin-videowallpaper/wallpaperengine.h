@@ -32,11 +32,10 @@ public slots:
     void play();
     void show();
 private slots:
+    void startDeferred();
     bool registerMenu();
     void checkResouce();
-#ifndef USE_LIBDMR
     void catchImage(const QImage &img);
-#endif
 private:
     WallpaperEnginePrivate *d;
 };
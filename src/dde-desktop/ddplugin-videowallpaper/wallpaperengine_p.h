@@ -8,9 +8,23 @@
 #include "wallpaperengine.h"
 #include "videoproxy.h"
 #include "videosurface.h"
+#include "framescaler.h"
+#include "occlusiontracker.h"
+#include "powerpolicy.h"
+#include "sessionmonitor.h"
+#include "transcodecache.h"
+#include "mediaindex.h"
+#include "gapmeter.h"
+#include "framering.h"
+#include "perfcounters.h"
+#include "decoderprobecache.h"
+#include "memorymanager.h"
+#include "playbackclock.h"
 
 #include <QFileSystemWatcher>
 #include <QUrl>
+#include <QTimer>
+#include <QElapsedTimer>
 
 #ifndef USE_LIBDMR
 #include <QtMultimedia/QMediaPlayer>
@@ -20,6 +34,15 @@
 
 namespace ddplugin_videowallpaper {
 
+enum PauseReason {
+    kPauseByPower = 0x01,
+    kPauseByLock = 0x02,
+    kPauseByIdle = 0x04,
+    kPauseByBlank = 0x08,
+    kPauseBySleep = 0x10,
+    kPauseByStandby = 0x20,
+};
+
 class WallpaperEnginePrivate
 {
 public:
@@ -28,25 +51,93 @@ public:
     {
         return QRect(QPoint(0, 0), geometry.size());
     }
+    QList<QUrl> sourceVideos(const QString &source) const;
 #ifndef USE_LIBDMR
-    static QList<QMediaContent> getVideos(const QString &path);
+    QList<QMediaContent> getVideos() const;
 #else
-    static QList<QUrl> getVideos(const QString &path);
+    QList<QUrl> getVideos(const QString &source) const;
 #endif
 public:
     VideoProxyPointer createWidget(QWidget *root);
-    void setBackgroundVisible(bool v);
+    void setBackgroundVisible(bool v, const QString &screen = QString());
+    void updateVisibility();
+    void updateMemory();
+    bool isScreenActive(const QString &screen) const;
+    void trimIdle();
+    void applyMemoryLimit();
+    void setMemoryTight(bool tight);
+    void enterStandby(int timeout);
+    void leaveStandby();
     QString sourcePath() const;
+    // the video directory or playlist file of screen.
+    QString sourceOf(const QString &screen) const;
+    QStringList sources() const;
+    QStringList sourceDirs() const;
+    void updateSources();
+    void applyFrameRate();
+    void updateScreens();
+    bool isScreenVisible(const QString &screen) const;
+    void updatePlayState();
+    void setPaused(PauseReason reason, bool paused);
+    void applyPowerLevel();
+    QSize transcodeSize() const;
+    void updateCache();
+    void applyFrameCache();
+    void applyScaleMode();
+    ScaleMode scaleMode() const;
+    // the canvas spanning all screens in pixels, it is null if the video is not spanned.
+    QRect spanCanvas(QMap<QString, QRect> *screens = nullptr) const;
+    QVariantMap perfStats() const;
+#ifndef USE_LIBDMR
+    void updatePlaylist();
+    void recordFrame(const QImage &img);
+    void stopRing();
+    void negotiateSurface();
+#else
+    void updatePlaylists();
+    QString playlistKey(const QString &screen) const;
+    QString streamKey(const QString &screen) const;
+    void shareDecoders();
+    void negotiateDecoders();
+#endif
     QMap<QString, VideoProxyPointer> widgets;
 
     QFileSystemWatcher *watcher = nullptr;
+    MediaIndex *index = nullptr;
+    bool checkPending = false;
+    FrameScaler *scaler = nullptr;
+    OcclusionTracker *occlusion = nullptr;
+    PowerPolicy *power = nullptr;
+    AbstractSessionSource *session = nullptr;
+    TranscodeCache *cache = nullptr;
+    QSize cacheSize;
+    PerfCountersDBus *perf = nullptr;
+    bool playing = false;
+    int pauseReasons = 0;
+    MemoryManager *memory = nullptr;
+    QTimer trimTimer;
+    bool standby = false;   // turned off but the players are kept
+    QTimer standbyTimer;
+    QElapsedTimer standbySince;
+    qint64 standbyRssBefore = 0;
+    qint64 standbyTrimmed = 0;
 #ifndef USE_LIBDMR
     QList<QMediaContent> videos;
     QMediaPlaylist *playlist = nullptr;
     QMediaPlayer *player = nullptr;
     VideoSurface *surface = nullptr;
+    GapMeter gap;
+    FrameRing *ring = nullptr;
+    bool ringActive = false;   // the frames come from ring, the player is stopped.
+    qint64 ringMaxLength = 0;   // ms
+    qint64 lastPts = -1;
+    QUrl ringRejected;
+    QRectF ringRegion;   // the region of frames in ring
+    QSize ringTarget;
 #else
-    QList<QUrl> videos;
+    QMap<QString, QList<QUrl>> videos;   // screen -- playlist
+    DecoderProbeCache *probes = nullptr;
+    PlaybackClock *clock = nullptr;
 #endif
 private:
     WallpaperEngine *q;
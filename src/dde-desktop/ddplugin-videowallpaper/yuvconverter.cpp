@@ -0,0 +1,324 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "yuvconverter.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#    define YUV_X86
+#    include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#    define YUV_NEON
+#    include <arm_neon.h>
+#endif
+
+using namespace ddplugin_videowallpaper;
+
+// all kernels use the same 6 bits fixed-point math, so that they output the same pixels.
+static constexpr YuvConverter::Coefficients kCoefficients[2][2] = {
+    {
+        { 16, 75, 102, 25, 52, 129 },   // BT.601 limited range
+        { 0, 64, 90, 22, 46, 113 },   // BT.601 full range
+    },
+    {
+        { 16, 75, 115, 14, 34, 135 },   // BT.709 limited range
+        { 0, 64, 101, 12, 30, 119 },   // BT.709 full range
+    }
+};
+
+static inline uint32_t clamp8(int v)
+{
+    return static_cast<uint32_t>(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+static inline uint32_t pixel(int y, int u, int v, const YuvConverter::Coefficients &c)
+{
+    const int ys = (y - c.yOffset) * c.y;
+    u -= 128;
+    v -= 128;
+    const int r = (ys + c.rv * v + 32) >> 6;
+    const int g = (ys - c.gu * u - c.gv * v + 32) >> 6;
+    const int b = (ys + c.bu * u + 32) >> 6;
+    return 0xff000000u | (clamp8(r) << 16) | (clamp8(g) << 8) | clamp8(b);
+}
+
+static void rowScalar(const uint8_t *y, const uint8_t *u, const uint8_t *v,
+                      uint32_t *dst, int width, const YuvConverter::Coefficients &c)
+{
+    for (int i = 0; i < width; ++i)
+        dst[i] = pixel(y[i], u[i], v[i], c);
+}
+
+#ifdef YUV_X86
+struct SseCoefficients
+{
+    __m128i yOffset, y, rv, gu, gv, bu, c128, rnd;
+};
+
+__attribute__((target("sse2"))) static inline void yuvToRgbSSE2(__m128i y, __m128i u, __m128i v, const SseCoefficients &k,
+                                                                 __m128i &r, __m128i &g, __m128i &b)
+{
+    y = _mm_mullo_epi16(_mm_sub_epi16(y, k.yOffset), k.y);
+    u = _mm_sub_epi16(u, k.c128);
+    v = _mm_sub_epi16(v, k.c128);
+    r = _mm_adds_epi16(y, _mm_mullo_epi16(v, k.rv));
+    g = _mm_subs_epi16(_mm_subs_epi16(y, _mm_mullo_epi16(u, k.gu)), _mm_mullo_epi16(v, k.gv));
+    b = _mm_adds_epi16(y, _mm_mullo_epi16(u, k.bu));
+    r = _mm_srai_epi16(_mm_adds_epi16(r, k.rnd), 6);
+    g = _mm_srai_epi16(_mm_adds_epi16(g, k.rnd), 6);
+    b = _mm_srai_epi16(_mm_adds_epi16(b, k.rnd), 6);
+}
+
+__attribute__((target("sse2"))) static void rowSSE2(const uint8_t *y, const uint8_t *u, const uint8_t *v,
+                                                     uint32_t *dst, int width, const YuvConverter::Coefficients &c)
+{
+    const SseCoefficients k = {
+        _mm_set1_epi16(c.yOffset), _mm_set1_epi16(c.y), _mm_set1_epi16(c.rv), _mm_set1_epi16(c.gu),
+        _mm_set1_epi16(c.gv), _mm_set1_epi16(c.bu), _mm_set1_epi16(128), _mm_set1_epi16(32)
+    };
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha = _mm_set1_epi8(-1);
+
+    int i = 0;
+    for (; i + 16 <= width; i += 16) {
+        const __m128i y8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + i));
+        const __m128i u8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(u + i));
+        const __m128i v8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(v + i));
+
+        __m128i rl, gl, bl, rh, gh, bh;
+        yuvToRgbSSE2(_mm_unpacklo_epi8(y8, zero), _mm_unpacklo_epi8(u8, zero), _mm_unpacklo_epi8(v8, zero), k, rl, gl, bl);
+        yuvToRgbSSE2(_mm_unpackhi_epi8(y8, zero), _mm_unpackhi_epi8(u8, zero), _mm_unpackhi_epi8(v8, zero), k, rh, gh, bh);
+
+        const __m128i r = _mm_packus_epi16(rl, rh);
+        const __m128i g = _mm_packus_epi16(gl, gh);
+        const __m128i b = _mm_packus_epi16(bl, bh);
+
+        // B G R A in memory
+        const __m128i bgl = _mm_unpacklo_epi8(b, g);
+        const __m128i bgh = _mm_unpackhi_epi8(b, g);
+        const __m128i ral = _mm_unpacklo_epi8(r, alpha);
+        const __m128i rah = _mm_unpackhi_epi8(r, alpha);
+
+        __m128i *out = reinterpret_cast<__m128i *>(dst + i);
+        _mm_storeu_si128(out, _mm_unpacklo_epi16(bgl, ral));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(bgl, ral));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(bgh, rah));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(bgh, rah));
+    }
+
+    rowScalar(y + i, u + i, v + i, dst + i, width - i, c);
+}
+
+struct AvxCoefficients
+{
+    __m256i yOffset, y, rv, gu, gv, bu, c128, rnd, zero, max, alpha;
+};
+
+__attribute__((target("avx2"))) static inline void storeAVX2(const uint8_t *y, const uint8_t *u, const uint8_t *v,
+                                                              uint32_t *dst, const AvxCoefficients &k)
+{
+    // 16 pixels in order
+    __m256i ys = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(y)));
+    __m256i us = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(u))), k.c128);
+    __m256i vs = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(v))), k.c128);
+
+    ys = _mm256_mullo_epi16(_mm256_sub_epi16(ys, k.yOffset), k.y);
+    __m256i r = _mm256_adds_epi16(ys, _mm256_mullo_epi16(vs, k.rv));
+    __m256i g = _mm256_subs_epi16(_mm256_subs_epi16(ys, _mm256_mullo_epi16(us, k.gu)), _mm256_mullo_epi16(vs, k.gv));
+    __m256i b = _mm256_adds_epi16(ys, _mm256_mullo_epi16(us, k.bu));
+    r = _mm256_min_epi16(_mm256_max_epi16(_mm256_srai_epi16(_mm256_adds_epi16(r, k.rnd), 6), k.zero), k.max);
+    g = _mm256_min_epi16(_mm256_max_epi16(_mm256_srai_epi16(_mm256_adds_epi16(g, k.rnd), 6), k.zero), k.max);
+    b = _mm256_min_epi16(_mm256_max_epi16(_mm256_srai_epi16(_mm256_adds_epi16(b, k.rnd), 6), k.zero), k.max);
+
+    const __m256i bg = _mm256_or_si256(b, _mm256_slli_epi16(g, 8));
+    const __m256i ra = _mm256_or_si256(r, k.alpha);
+
+    // the unpacking works in each 128 bits lane: lo is pixels 0-3 and 8-11, hi is 4-7 and 12-15.
+    const __m256i lo = _mm256_unpacklo_epi16(bg, ra);
+    const __m256i hi = _mm256_unpackhi_epi16(bg, ra);
+    __m256i *out = reinterpret_cast<__m256i *>(dst);
+    _mm256_storeu_si256(out, _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+__attribute__((target("avx2"))) static void rowAVX2(const uint8_t *y, const uint8_t *u, const uint8_t *v,
+                                                     uint32_t *dst, int width, const YuvConverter::Coefficients &c)
+{
+    const AvxCoefficients k = {
+        _mm256_set1_epi16(c.yOffset), _mm256_set1_epi16(c.y), _mm256_set1_epi16(c.rv), _mm256_set1_epi16(c.gu),
+        _mm256_set1_epi16(c.gv), _mm256_set1_epi16(c.bu), _mm256_set1_epi16(128), _mm256_set1_epi16(32),
+        _mm256_setzero_si256(), _mm256_set1_epi16(255), _mm256_set1_epi16(static_cast<short>(0xff00))
+    };
+
+    int i = 0;
+    for (; i + 16 <= width; i += 16)
+        storeAVX2(y + i, u + i, v + i, dst + i, k);
+
+    rowScalar(y + i, u + i, v + i, dst + i, width - i, c);
+}
+#endif
+
+#ifdef YUV_NEON
+static void rowNEON(const uint8_t *y, const uint8_t *u, const uint8_t *v,
+                    uint32_t *dst, int width, const YuvConverter::Coefficients &c)
+{
+    const int16x8_t yOffset = vdupq_n_s16(c.yOffset);
+    const int16x8_t yc = vdupq_n_s16(c.y);
+    const int16x8_t rv = vdupq_n_s16(c.rv);
+    const int16x8_t gu = vdupq_n_s16(c.gu);
+    const int16x8_t gv = vdupq_n_s16(c.gv);
+    const int16x8_t bu = vdupq_n_s16(c.bu);
+    const int16x8_t c128 = vdupq_n_s16(128);
+    const int16x8_t rnd = vdupq_n_s16(32);
+
+    int i = 0;
+    for (; i + 8 <= width; i += 8) {
+        int16x8_t ys = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(y + i)));
+        int16x8_t us = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(u + i))), c128);
+        int16x8_t vs = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(v + i))), c128);
+
+        ys = vmulq_s16(vsubq_s16(ys, yOffset), yc);
+        int16x8_t r = vqaddq_s16(ys, vmulq_s16(vs, rv));
+        int16x8_t g = vqsubq_s16(vqsubq_s16(ys, vmulq_s16(us, gu)), vmulq_s16(vs, gv));
+        int16x8_t b = vqaddq_s16(ys, vmulq_s16(us, bu));
+
+        uint8x8x4_t px;
+        px.val[0] = vqmovun_s16(vshrq_n_s16(vqaddq_s16(b, rnd), 6));
+        px.val[1] = vqmovun_s16(vshrq_n_s16(vqaddq_s16(g, rnd), 6));
+        px.val[2] = vqmovun_s16(vshrq_n_s16(vqaddq_s16(r, rnd), 6));
+        px.val[3] = vdup_n_u8(255);
+        vst4_u8(reinterpret_cast<uint8_t *>(dst + i), px);
+    }
+
+    rowScalar(y + i, u + i, v + i, dst + i, width - i, c);
+}
+#endif
+
+YuvConverter::YuvConverter(ColorSpace space, ColorRange range, Kernel kernel)
+    : coef(kCoefficients[space == kBT709 ? 1 : 0][range == kFull ? 1 : 0])
+{
+    if (kernel == kAuto || !isSupported(kernel))
+        kernel = bestKernel();
+
+    used = kernel;
+    switch (kernel) {
+#ifdef YUV_X86
+    case kSSE2:
+        row = rowSSE2;
+        break;
+    case kAVX2:
+        row = rowAVX2;
+        break;
+#endif
+#ifdef YUV_NEON
+    case kNEON:
+        row = rowNEON;
+        break;
+#endif
+    default:
+        used = kScalar;
+        row = rowScalar;
+        break;
+    }
+}
+
+bool YuvConverter::isSupported(Kernel kernel)
+{
+    switch (kernel) {
+    case kScalar:
+        return true;
+#ifdef YUV_X86
+    case kSSE2:
+        return __builtin_cpu_supports("sse2");
+    case kAVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+#ifdef YUV_NEON
+    case kNEON:
+        return true;
+#endif
+    default:
+        break;
+    }
+    return false;
+}
+
+YuvConverter::Kernel YuvConverter::bestKernel()
+{
+    for (Kernel k : { kAVX2, kSSE2, kNEON }) {
+        if (isSupported(k))
+            return k;
+    }
+    return kScalar;
+}
+
+const char *YuvConverter::kernelName(Kernel kernel)
+{
+    switch (kernel) {
+    case kScalar:
+        return "scalar";
+    case kSSE2:
+        return "sse2";
+    case kAVX2:
+        return "avx2";
+    case kNEON:
+        return "neon";
+    default:
+        break;
+    }
+    return "auto";
+}
+
+bool YuvConverter::convert(const YuvFrame &src, uint8_t *dst, int dstStride, int dstWidth, int dstHeight)
+{
+    if (!src.y || !src.u || (src.layout == YuvFrame::kI420 && !src.v) || !dst
+            || src.width < 2 || src.height < 2 || dstWidth < 1 || dstHeight < 1)
+        return false;
+
+    const bool sameWidth = dstWidth == src.width;
+    xmap.resize(static_cast<size_t>(dstWidth));
+    for (int x = 0; x < dstWidth; ++x)
+        xmap[x] = static_cast<int>((2 * static_cast<int64_t>(x) + 1) * src.width / (2 * static_cast<int64_t>(dstWidth)));
+
+    rowY.resize(static_cast<size_t>(dstWidth));
+    rowU.resize(static_cast<size_t>(dstWidth));
+    rowV.resize(static_cast<size_t>(dstWidth));
+
+    int chromaRow = -1;
+    for (int dy = 0; dy < dstHeight; ++dy) {
+        const int sy = static_cast<int>((2 * static_cast<int64_t>(dy) + 1) * src.height / (2 * static_cast<int64_t>(dstHeight)));
+        const uint8_t *ys = src.y + static_cast<int64_t>(sy) * src.yStride;
+
+        // one chroma row serves two luma rows, expand it once.
+        if (sy / 2 != chromaRow) {
+            chromaRow = sy / 2;
+            if (src.layout == YuvFrame::kNV12) {
+                const uint8_t *uv = src.u + static_cast<int64_t>(chromaRow) * src.uStride;
+                for (int x = 0; x < dstWidth; ++x) {
+                    const int cx = (xmap[x] >> 1) << 1;
+                    rowU[x] = uv[cx];
+                    rowV[x] = uv[cx + 1];
+                }
+            } else {
+                const uint8_t *us = src.u + static_cast<int64_t>(chromaRow) * src.uStride;
+                const uint8_t *vs = src.v + static_cast<int64_t>(chromaRow) * src.vStride;
+                for (int x = 0; x < dstWidth; ++x) {
+                    rowU[x] = us[xmap[x] >> 1];
+                    rowV[x] = vs[xmap[x] >> 1];
+                }
+            }
+        }
+
+        if (!sameWidth) {
+            for (int x = 0; x < dstWidth; ++x)
+                rowY[x] = ys[xmap[x]];
+            ys = rowY.data();
+        }
+
+        row(ys, rowU.data(), rowV.data(), reinterpret_cast<uint32_t *>(dst + static_cast<int64_t>(dy) * dstStride), dstWidth, coef);
+    }
+
+    return true;
+}
@@ -0,0 +1,68 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef YUVCONVERTER_H
+#define YUVCONVERTER_H
+
+#include <cstdint>
+#include <vector>
+
+namespace ddplugin_videowallpaper {
+
+struct YuvFrame
+{
+    enum Layout { kI420, kNV12 };
+    Layout layout = kI420;
+    int width = 0;
+    int height = 0;
+    const uint8_t *y = nullptr;
+    const uint8_t *u = nullptr;   // interleaved UV for NV12
+    const uint8_t *v = nullptr;
+    int yStride = 0;
+    int uStride = 0;
+    int vStride = 0;
+};
+
+// converts 4:2:0 frames to 0xffRRGGBB pixels, the layout of QImage::Format_RGB32.
+class YuvConverter
+{
+public:
+    enum ColorSpace { kBT601, kBT709 };
+    enum ColorRange { kLimited, kFull };
+    enum Kernel { kAuto, kScalar, kSSE2, kAVX2, kNEON };
+
+    explicit YuvConverter(ColorSpace space = kBT601, ColorRange range = kLimited, Kernel kernel = kAuto);
+    static bool isSupported(Kernel kernel);
+    static Kernel bestKernel();
+    static const char *kernelName(Kernel kernel);
+    Kernel kernel() const { return used; }
+
+    // the frame is scaled down to dstWidth x dstHeight by nearest sampling in the same pass.
+    bool convert(const YuvFrame &src, uint8_t *dst, int dstStride, int dstWidth, int dstHeight);
+
+    struct Coefficients
+    {
+        int16_t yOffset;
+        int16_t y;
+        int16_t rv;
+        int16_t gu;
+        int16_t gv;
+        int16_t bu;
+    };
+    typedef void (*RowFunc)(const uint8_t *y, const uint8_t *u, const uint8_t *v,
+                            uint32_t *dst, int width, const Coefficients &c);
+private:
+    Coefficients coef;
+    Kernel used;
+    RowFunc row = nullptr;
+    // full width chroma rows and the sampled luma row.
+    std::vector<uint8_t> rowY;
+    std::vector<uint8_t> rowU;
+    std::vector<uint8_t> rowV;
+    std::vector<int> xmap;
+};
+
+}
+
+#endif // YUVCONVERTER_H